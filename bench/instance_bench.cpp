@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "dsp/multires_phaser.hpp"
+#include "dsp/parameter_block.hpp"
+#include "dsp/phaser.hpp"
+
+namespace {
+
+struct Options {
+    size_t num_instances{200};
+    size_t num_channels{2};
+    size_t num_rounds{5};
+};
+
+// the dsp members of EmptyAudioProcessor, what a host pays for them when it scans or opens a project
+struct Instance {
+    phaser::SharedParameters params;
+    phaser::SpectralPhaser single;
+    phaser::MultiResolutionPhaser multires;
+};
+
+struct Timing {
+    double construct_us{};
+    double init_us{};
+    // prepareToPlay() again with the same bus, only the sample rate changed
+    double reinit_us{};
+    double destroy_us{};
+};
+
+double Since(std::chrono::steady_clock::time_point begin) noexcept {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// every instance stays alive until all are built, like the plugins of one project
+Timing Round(Options const& opt) {
+    std::vector<std::unique_ptr<Instance>> instances(opt.num_instances);
+    Timing t;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (auto& p : instances) {
+        p = std::make_unique<Instance>();
+        p->single.SetParameters(&p->params);
+        p->multires.SetParameters(&p->params);
+    }
+    t.construct_us = Since(begin);
+
+    // prepareToPlay(), both engines are prepared whichever one runs
+    begin = std::chrono::steady_clock::now();
+    for (auto& p : instances) {
+        p->single.Init(48000.0f, opt.num_channels);
+        p->multires.Init(48000.0f, opt.num_channels);
+    }
+    t.init_us = Since(begin);
+
+    begin = std::chrono::steady_clock::now();
+    for (auto& p : instances) {
+        p->single.Init(44100.0f, opt.num_channels);
+        p->multires.Init(44100.0f, opt.num_channels);
+    }
+    t.reinit_us = Since(begin);
+
+    begin = std::chrono::steady_clock::now();
+    instances.clear();
+    t.destroy_us = Since(begin);
+    return t;
+}
+
+void PrintUsage() {
+    std::printf("usage: instance_bench [--instances n] [--channels n] [--rounds n]\n"
+                "  --instances  instances alive at once, default 200\n"
+                "  --channels   bus size, default 2\n"
+                "  --rounds     the fastest round is reported, default 5\n");
+}
+
+bool ParseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        bool const has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--instances") == 0 && has_value) {
+            opt.num_instances = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (std::strcmp(argv[i], "--channels") == 0 && has_value) {
+            opt.num_channels = std::clamp<size_t>(static_cast<size_t>(std::atoi(argv[++i])), 1,
+                                                  phaser::SpectralPhaser::kMaxChannels);
+        }
+        else if (std::strcmp(argv[i], "--rounds") == 0 && has_value) {
+            opt.num_rounds = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        }
+        else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!ParseArgs(argc, argv, opt)) {
+        PrintUsage();
+        return 2;
+    }
+
+    // the first instance of the process also builds the tables every later one shares
+    auto begin = std::chrono::steady_clock::now();
+    {
+        auto first = std::make_unique<Instance>();
+        first->single.Init(48000.0f, opt.num_channels);
+        first->multires.Init(48000.0f, opt.num_channels);
+    }
+    double const first_us = Since(begin);
+
+    Timing best{1e30, 1e30, 1e30, 1e30};
+    for (size_t r = 0; r < opt.num_rounds; ++r) {
+        Timing const t = Round(opt);
+        best.construct_us = std::min(best.construct_us, t.construct_us);
+        best.init_us = std::min(best.init_us, t.init_us);
+        best.reinit_us = std::min(best.reinit_us, t.reinit_us);
+        best.destroy_us = std::min(best.destroy_us, t.destroy_us);
+    }
+
+    double const n = static_cast<double>(opt.num_instances);
+    std::printf("%zu instances, %zu channels, best of %zu rounds\n", opt.num_instances, opt.num_channels,
+                opt.num_rounds);
+    std::printf("%12s %12s %12s %12s %12s %12s\n", "first us", "construct us", "init us", "reinit us", "destroy us",
+                "total us");
+    std::printf("%12.1f %12.2f %12.1f %12.2f %12.1f %12.1f\n", first_us, best.construct_us / n, best.init_us / n,
+                best.reinit_us / n, best.destroy_us / n, (best.construct_us + best.init_us + best.destroy_us) / n);
+    return 0;
+}
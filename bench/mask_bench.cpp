@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "dsp/phaser.hpp"
+
+namespace {
+
+constexpr size_t kFftSize = 1024;
+constexpr size_t kHopSize = 256;
+constexpr size_t kNumBins = kFftSize / 2 + 1;
+constexpr size_t kNumBinsPadded = qwqdsp_simd::PadSize(kNumBins);
+constexpr size_t kNumHops = 20000;
+
+// the per layer, per channel loop SpectralPhaser used before the mask cache
+float ReferenceWarp(float x, float morph) noexcept {
+    return std::lerp(x, std::log(x + 1), morph);
+}
+
+float ReferenceSinReaktor(float x) noexcept {
+    x = 2 * std::abs(x - 0.5f) - 0.5f;
+    float const x2 = x * x;
+    float u = -0.540347434104161f * x2 + 2.535656174488765f;
+    u = u * x2 - 5.166512943349853f;
+    u = u * x2 + 3.141592653589793f;
+    return u * x;
+}
+
+void ReferenceProcess(phaser::SpectralPhaserLayer const& layer, float* re, float* im) noexcept {
+    if (!layer.enable) return;
+
+    float dry = 1 - layer.drywet;
+    float wet = layer.drywet;
+    for (size_t i = 0; i < kNumBins; ++i) {
+        float flange_phase = ReferenceWarp(static_cast<float>(i), layer.morph) / layer.GetSpace();
+        flange_phase += layer.phase;
+        flange_phase += layer.GetLfoPhase();
+        flange_phase -= std::floor(flange_phase);
+        float g = ReferenceSinReaktor(flange_phase) * 0.5f + 0.5f;
+        re[i] = dry * re[i] + wet * g * re[i];
+        im[i] = dry * im[i] + wet * g * im[i];
+    }
+}
+
+struct Setup {
+    std::array<phaser::SpectralPhaserLayer, phaser::SpectralMask::kNumLayers> layers;
+    std::vector<float> re = std::vector<float>(kNumBinsPadded * 2, 1.0f);
+    std::vector<float> im = std::vector<float>(kNumBinsPadded * 2, 1.0f);
+
+    explicit Setup(size_t num_layers, bool moving) {
+        for (size_t i = 0; i < layers.size(); ++i) {
+            auto& l = layers[i];
+            l.enable = i < num_layers;
+            l.pitch = 60.0f + 10.0f * static_cast<float>(i);
+            l.morph = 0.5f;
+            l.phase = 0.25f;
+            l.drywet = 0.8f;
+            l.barber_freq = moving ? 0.3f : 0.0f;
+        }
+    }
+
+    void Tick() noexcept {
+        // keep the spectrum away from denormals
+        std::fill(re.begin(), re.end(), 1.0f);
+        std::fill(im.begin(), im.end(), 1.0f);
+        for (auto& l : layers) {
+            l.Update(48000.0f, static_cast<float>(kFftSize), static_cast<float>(kHopSize));
+        }
+    }
+};
+
+template <class Func>
+double NsPerHop(Func&& func) {
+    auto const begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kNumHops; ++i) {
+        func();
+    }
+    auto const end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / static_cast<double>(kNumHops);
+}
+
+double BenchReference(size_t num_layers, bool moving) {
+    Setup s{num_layers, moving};
+    return NsPerHop([&] {
+        s.Tick();
+        // left and right
+        for (size_t ch = 0; ch < 2; ++ch) {
+            for (auto const& l : s.layers) {
+                ReferenceProcess(l, s.re.data() + ch * kNumBinsPadded, s.im.data() + ch * kNumBinsPadded);
+            }
+        }
+    });
+}
+
+template <class V>
+double BenchMask(size_t num_layers, bool moving) {
+    Setup s{num_layers, moving};
+    phaser::BasicSpectralMask<V> mask;
+    qwqdsp_memory::Arena arena;
+    arena.Carve([&mask](qwqdsp_memory::Arena& a) { mask.Carve(a, kNumBins); });
+    mask.Prepare(kNumBins, 1.0f);
+    return NsPerHop([&] {
+        s.Tick();
+        mask.Update(s.layers);
+        for (size_t ch = 0; ch < 2; ++ch) {
+            mask.Apply(s.re.data() + ch * kNumBinsPadded, s.im.data() + ch * kNumBinsPadded);
+        }
+    });
+}
+
+} // namespace
+
+int main() {
+    std::printf("mask cost per hop, stereo, %zu bins, simd width %zu\n", kNumBins, qwqdsp_simd::Native::kWidth);
+    std::printf("%-7s %-7s %12s %12s %12s %9s\n", "layers", "barber", "old ns", "scalar ns", "simd ns", "speedup");
+    for (bool moving : {true, false}) {
+        for (size_t num_layers : {size_t{1}, size_t{2}, size_t{4}}) {
+            double const ref = BenchReference(num_layers, moving);
+            double const scalar = BenchMask<qwqdsp_simd::Scalar>(num_layers, moving);
+            double const simd = BenchMask<qwqdsp_simd::Native>(num_layers, moving);
+            std::printf("%-7zu %-7s %12.1f %12.1f %12.1f %8.1fx\n", num_layers, moving ? "on" : "off", ref, scalar,
+                        simd, ref / simd);
+        }
+    }
+    return 0;
+}
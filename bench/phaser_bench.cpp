@@ -0,0 +1,447 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <numbers>
+#include <random>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "dsp/multires_phaser.hpp"
+#include "dsp/phaser.hpp"
+
+namespace {
+
+constexpr size_t kBlockSizes[]{16, 32, 64, 128, 256, 512, 1024, 2048, 4096};
+constexpr float kSampleRates[]{44100.0f, 48000.0f, 96000.0f};
+constexpr size_t kLayerCounts[]{0, 1, 2, 4};
+// seconds of audio rendered per case, after the warm up
+constexpr float kSeconds = 10.0f;
+constexpr float kWarmUpSeconds = 1.0f;
+
+struct Case {
+    size_t block_size{};
+    float fs{};
+    size_t num_layers{};
+    bool phasy{};
+
+    // the rates are whole Hz, compared as such
+    long Hz() const noexcept {
+        return std::lround(fs);
+    }
+
+    bool SameAs(Case const& other) const noexcept {
+        return block_size == other.block_size && Hz() == other.Hz() && num_layers == other.num_layers &&
+               phasy == other.phasy;
+    }
+};
+
+struct Result {
+    Case c;
+    double ns_per_sample{};
+    // seconds of audio per second of cpu
+    double realtime{};
+    double p99_us{};
+    // percent of the bins the sparse mode left dry
+    double skipped{};
+};
+
+struct Options {
+    bool multires{};
+    bool quick{};
+    bool lowpass{};
+    size_t num_channels{2};
+    // SpectralPhaser only
+    size_t num_workers{};
+    bool sparse{};
+    float sparse_db{-60.0f};
+    char const* json_path{};
+    char const* baseline_path{};
+    // percent, a slower ns/sample than this counts as a regression
+    double threshold{5.0};
+};
+
+// what a run measured, two runs only compare with the same setup
+struct Setup {
+    bool multires{};
+    size_t num_channels{};
+    size_t num_workers{};
+    bool lowpass{};
+    bool sparse{};
+    // whole dB, like the json holds it
+    long sparse_db{};
+
+    bool operator==(Setup const&) const = default;
+};
+
+Setup GetSetup(Options const& opt) {
+    return {opt.multires, opt.num_channels, opt.num_workers, opt.lowpass, opt.sparse,
+            opt.sparse ? std::lround(opt.sparse_db) : 0};
+}
+
+void PrintSetup(char const* name, Setup const& s) {
+    std::printf("%s: %s engine, %zu channels, %zu workers, lowpass %s, sparse %s", name,
+                s.multires ? "multires" : "single", s.num_channels, s.num_workers, s.lowpass ? "on" : "off",
+                s.sparse ? "on" : "off");
+    if (s.sparse) std::printf(" at %ld dB", s.sparse_db);
+    std::printf("\n");
+}
+
+template <class Dsp>
+void SetupLayers(Dsp& dsp, Case const& c) {
+    dsp.phasy = c.phasy;
+    for (size_t i = 0; i < Dsp::kNumLayers; ++i) {
+        auto& l = dsp.GetLayer(i);
+        l.enable = i < c.num_layers;
+        l.pitch = 60.0f + 10.0f * static_cast<float>(i);
+        l.morph = 0.5f;
+        l.phase = 0.25f;
+        l.drywet = 0.8f;
+        l.barber_freq = 0.3f;
+    }
+}
+
+// the per block work of EmptyAudioProcessor::processBlock() without the host
+template <class Dsp>
+Result Run(Dsp& dsp, Case const& c, Options const& opt) {
+    qwqdsp_perf::PerfCounters perf;
+    if constexpr (std::is_same_v<Dsp, phaser::SpectralPhaser>) {
+        // any channel count or fft size engages the workers
+        dsp.Init(c.fs, opt.num_channels, {.num_workers = opt.num_workers, .min_channels = 0, .min_fft_size = 0});
+        dsp.SetSparse({.enable = opt.sparse, .threshold_db = opt.sparse_db});
+        dsp.SetPerfCounters(opt.sparse ? &perf : nullptr);
+    }
+    else {
+        dsp.Init(c.fs, opt.num_channels);
+    }
+    SetupLayers(dsp, c);
+
+    size_t const warm_up = static_cast<size_t>(kWarmUpSeconds * c.fs) / c.block_size + 1;
+    size_t const num_blocks = static_cast<size_t>(kSeconds * c.fs) / c.block_size + 1;
+
+    std::vector<float> audio(opt.num_channels * c.block_size);
+    std::vector<float*> channels(opt.num_channels);
+    for (size_t ch = 0; ch < opt.num_channels; ++ch) {
+        channels[ch] = audio.data() + ch * c.block_size;
+    }
+    std::minstd_rand rng{1};
+    std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+    // four one poles at 500Hz, -24dB per octave like a bass stem
+    float const pole = 1.0f - std::exp(-2.0f * std::numbers::pi_v<float> * 500.0f / c.fs);
+    std::vector<std::array<float, 4>> poles(opt.num_channels);
+    auto fill = [&] {
+        // noise, so the output never decays into denormals
+        for (auto& x : audio) {
+            x = dist(rng);
+        }
+        if (!opt.lowpass) return;
+        for (size_t ch = 0; ch < opt.num_channels; ++ch) {
+            for (float& x : std::span{channels[ch], c.block_size}) {
+                for (float& s : poles[ch]) {
+                    s += pole * (x - s);
+                    x = s;
+                }
+            }
+        }
+    };
+
+    std::vector<double> callback_ns;
+    callback_ns.reserve(num_blocks);
+    double total_ns = 0;
+    for (size_t b = 0; b < warm_up + num_blocks; ++b) {
+        fill();
+        auto const begin = std::chrono::steady_clock::now();
+        dsp.Update();
+        dsp.Process(channels, c.block_size);
+        auto const end = std::chrono::steady_clock::now();
+        if (b >= warm_up) {
+            double const ns = std::chrono::duration<double, std::nano>(end - begin).count();
+            callback_ns.push_back(ns);
+            total_ns += ns;
+        }
+    }
+
+    size_t const p99 = std::min(callback_ns.size() - 1, callback_ns.size() * 99 / 100);
+    std::nth_element(callback_ns.begin(), callback_ns.begin() + static_cast<std::ptrdiff_t>(p99), callback_ns.end());
+
+    // per sample frame of the whole bus
+    double const num_samples = static_cast<double>(num_blocks * c.block_size);
+    Result r;
+    r.c = c;
+    r.ns_per_sample = total_ns / num_samples;
+    r.realtime = num_samples / static_cast<double>(c.fs) / (total_ns * 1e-9);
+    r.p99_us = callback_ns[p99] * 1e-3;
+    uint64_t const bins = perf.sparse_bins.load(std::memory_order_relaxed);
+    if (bins != 0) {
+        r.skipped = static_cast<double>(perf.skipped_bins.load(std::memory_order_relaxed)) /
+                    static_cast<double>(bins) * 100.0;
+    }
+    if constexpr (std::is_same_v<Dsp, phaser::SpectralPhaser>) {
+        dsp.SetPerfCounters(nullptr);
+    }
+    return r;
+}
+
+std::vector<Case> MakeCases(Options const& opt) {
+    std::vector<Case> cases;
+    for (float fs : kSampleRates) {
+        if (opt.quick && std::lround(fs) != 48000) continue;
+        for (size_t num_layers : kLayerCounts) {
+            for (bool phasy : {false, true}) {
+                if (opt.quick && phasy) continue;
+                for (size_t block_size : kBlockSizes) {
+                    cases.push_back({block_size, fs, num_layers, phasy});
+                }
+            }
+        }
+    }
+    return cases;
+}
+
+// one case per line, so the baseline can be read back without a json library
+bool WriteJson(char const* path, Options const& opt, std::vector<Result> const& results) {
+    FILE* f = std::fopen(path, "w");
+    if (f == nullptr) return false;
+    std::fprintf(f,
+                 "{\n  \"engine\": \"%s\",\n  \"simd_width\": %zu,\n  \"channels\": %zu,\n  \"workers\": %zu,\n"
+                 "  \"lowpass\": %d,\n  \"sparse\": %d,\n  \"sparse_db\": %ld,\n  \"results\": [\n",
+                 opt.multires ? "multires" : "single", qwqdsp_simd::Native::kWidth, opt.num_channels, opt.num_workers,
+                 opt.lowpass ? 1 : 0, opt.sparse ? 1 : 0, GetSetup(opt).sparse_db);
+    for (size_t i = 0; i < results.size(); ++i) {
+        auto const& r = results[i];
+        std::fprintf(f,
+                     "    {\"block_size\": %zu, \"fs\": %.0f, \"layers\": %zu, \"phasy\": %d, "
+                     "\"ns_per_sample\": %.4f, \"realtime\": %.2f, \"p99_us\": %.3f}%s\n",
+                     r.c.block_size, static_cast<double>(r.c.fs), r.c.num_layers, r.c.phasy ? 1 : 0,
+                     r.ns_per_sample, r.realtime, r.p99_us, i + 1 == results.size() ? "" : ",");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    std::fclose(f);
+    return true;
+}
+
+/**
+ * @return false if the file can not be read or its header lacks a field of Setup
+ */
+bool ReadJson(char const* path, Setup& setup, std::vector<Result>& results) {
+    FILE* f = std::fopen(path, "r");
+    if (f == nullptr) return false;
+    char line[512];
+    // one bit per field of setup
+    unsigned fields = 0;
+    while (std::fgets(line, sizeof(line), f) != nullptr) {
+        char engine[16]{};
+        int flag = 0;
+        if (std::sscanf(line, " \"engine\": \"%15[a-z]\"", engine) == 1) {
+            setup.multires = std::strcmp(engine, "multires") == 0;
+            fields |= 1;
+            continue;
+        }
+        if (std::sscanf(line, " \"channels\": %zu", &setup.num_channels) == 1) {
+            fields |= 2;
+            continue;
+        }
+        if (std::sscanf(line, " \"workers\": %zu", &setup.num_workers) == 1) {
+            fields |= 4;
+            continue;
+        }
+        if (std::sscanf(line, " \"lowpass\": %d", &flag) == 1) {
+            setup.lowpass = flag != 0;
+            fields |= 8;
+            continue;
+        }
+        if (std::sscanf(line, " \"sparse\": %d", &flag) == 1) {
+            setup.sparse = flag != 0;
+            fields |= 16;
+            continue;
+        }
+        if (std::sscanf(line, " \"sparse_db\": %ld", &setup.sparse_db) == 1) {
+            fields |= 32;
+            continue;
+        }
+
+        Result r;
+        double fs = 0;
+        int phasy = 0;
+        int const n = std::sscanf(line,
+                                  " {\"block_size\": %zu, \"fs\": %lf, \"layers\": %zu, \"phasy\": %d, "
+                                  "\"ns_per_sample\": %lf, \"realtime\": %lf, \"p99_us\": %lf",
+                                  &r.c.block_size, &fs, &r.c.num_layers, &phasy, &r.ns_per_sample, &r.realtime,
+                                  &r.p99_us);
+        if (n == 7) {
+            r.c.fs = static_cast<float>(fs);
+            r.c.phasy = phasy != 0;
+            results.push_back(r);
+        }
+    }
+    std::fclose(f);
+    return fields == 63;
+}
+
+/**
+ * @return number of cases slower than the threshold
+ */
+size_t Compare(std::vector<Result> const& baseline, std::vector<Result> const& results, double threshold) {
+    std::printf("\ncompared to baseline, positive is slower\n");
+    std::printf("%6s %6s %6s %5s %12s %12s %8s %10s\n", "block", "fs", "layers", "phasy", "base ns/smp", "ns/smp",
+                "change", "p99 change");
+    size_t num_slower = 0;
+    double log_sum = 0;
+    size_t num_matched = 0;
+    for (auto const& r : results) {
+        auto it = std::find_if(baseline.begin(), baseline.end(), [&](Result const& b) { return b.c.SameAs(r.c); });
+        if (it == baseline.end()) continue;
+        double const change = (r.ns_per_sample / it->ns_per_sample - 1.0) * 100.0;
+        double const p99_change = (r.p99_us / it->p99_us - 1.0) * 100.0;
+        bool const slower = change > threshold;
+        num_slower += slower ? 1 : 0;
+        log_sum += std::log(r.ns_per_sample / it->ns_per_sample);
+        ++num_matched;
+        std::printf("%6zu %6.0f %6zu %5s %12.3f %12.3f %+7.1f%% %+9.1f%%%s\n", r.c.block_size,
+                    static_cast<double>(r.c.fs), r.c.num_layers, r.c.phasy ? "on" : "off", it->ns_per_sample,
+                    r.ns_per_sample, change, p99_change, slower ? "  <- slower" : "");
+    }
+    if (num_matched == 0) {
+        std::printf("no case of the baseline matches\n");
+        return 0;
+    }
+    std::printf("geometric mean %+.1f%% over %zu cases, %zu slower than %.1f%%\n",
+                (std::exp(log_sum / static_cast<double>(num_matched)) - 1.0) * 100.0, num_matched, num_slower,
+                threshold);
+    return num_slower;
+}
+
+void PrintUsage() {
+    std::printf("usage: phaser_bench [--multires] [--quick] [--channels n] [--workers n] [--lowpass]\n"
+                "                    [--sparse db] [--json out.json] [--compare baseline.json] [--threshold percent]\n"
+                "  --multires   run MultiResolutionPhaser instead of SpectralPhaser\n"
+                "  --channels   bus size, default 2\n"
+                "  --workers    worker threads of SpectralPhaser, always engaged, default 0\n"
+                "  --lowpass    the noise lowpassed at 500Hz, like a bass stem\n"
+                "  --sparse     sparse mode of SpectralPhaser with this threshold in dB, prints the bins skipped\n"
+                "  --quick      48kHz and phasy off only\n"
+                "  --json       write the results, can be used as a baseline later\n"
+                "  --compare    compare ns/sample with a saved run of the same setup, exits with 1 if a case got slower\n"
+                "  --threshold  percent a case may be slower before it counts, default 5\n");
+}
+
+bool ParseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        bool const has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--multires") == 0) {
+            opt.multires = true;
+        }
+        else if (std::strcmp(argv[i], "--quick") == 0) {
+            opt.quick = true;
+        }
+        else if (std::strcmp(argv[i], "--channels") == 0 && has_value) {
+            opt.num_channels = std::clamp<size_t>(static_cast<size_t>(std::atoi(argv[++i])), 1,
+                                                  phaser::SpectralPhaser::kMaxChannels);
+        }
+        else if (std::strcmp(argv[i], "--workers") == 0 && has_value) {
+            opt.num_workers = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        }
+        else if (std::strcmp(argv[i], "--lowpass") == 0) {
+            opt.lowpass = true;
+        }
+        else if (std::strcmp(argv[i], "--sparse") == 0 && has_value) {
+            opt.sparse = true;
+            opt.sparse_db = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--json") == 0 && has_value) {
+            opt.json_path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--compare") == 0 && has_value) {
+            opt.baseline_path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--threshold") == 0 && has_value) {
+            opt.threshold = std::atof(argv[++i]);
+        }
+        else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!ParseArgs(argc, argv, opt)) {
+        PrintUsage();
+        return 2;
+    }
+
+    std::vector<Result> baseline;
+    if (opt.baseline_path != nullptr) {
+        Setup base;
+        if (!ReadJson(opt.baseline_path, base, baseline)) {
+            std::fprintf(stderr, "can not read %s, or it has no full setup header\n", opt.baseline_path);
+            return 2;
+        }
+        if (base != GetSetup(opt)) {
+            std::printf("the baseline was measured with another setup, not comparing\n");
+            PrintSetup("baseline", base);
+            PrintSetup("this run", GetSetup(opt));
+            return 2;
+        }
+    }
+
+    // large members, keep them off the stack
+    auto single = std::make_unique<phaser::SpectralPhaser>();
+    auto multires = std::make_unique<phaser::MultiResolutionPhaser>();
+
+    std::printf("%s engine, simd width %zu, %zu channels, %zu workers, %.0f s of audio per case\n",
+                opt.multires ? "multires" : "single", qwqdsp_simd::Native::kWidth, opt.num_channels, opt.num_workers,
+                static_cast<double>(kSeconds));
+    if (opt.lowpass) {
+        std::printf("noise lowpassed at 500Hz\n");
+    }
+    if (opt.sparse) {
+        std::printf("sparse, bands %.0f dB below the loudest are skipped\n", static_cast<double>(opt.sparse_db));
+    }
+    // the footprint does not depend on the sample rate or the layers
+    qwqdsp_memory::Footprint footprint;
+    if (opt.multires) {
+        multires->Init(48000.0f, opt.num_channels);
+        footprint = multires->GetFootprint();
+    }
+    else {
+        single->Init(48000.0f, opt.num_channels, {.num_workers = opt.num_workers});
+        footprint = single->GetFootprint();
+    }
+    std::printf("%.1f KiB per instance, %.1f KiB object, %.1f KiB arena in %zu buffers, "
+                "%zu ffts with shared twiddles not counted\n",
+                static_cast<double>(footprint.TotalBytes()) / 1024.0,
+                static_cast<double>(footprint.object_bytes) / 1024.0,
+                static_cast<double>(footprint.arena_bytes) / 1024.0, footprint.num_buffers, footprint.num_ffts);
+    std::printf("%6s %6s %6s %5s %10s %10s %10s %10s%s\n", "block", "fs", "layers", "phasy", "ns/sample", "realtime",
+                "p99 us", "budget us", opt.sparse ? "     skip %" : "");
+    std::vector<Result> results;
+    for (auto const& c : MakeCases(opt)) {
+        Result const r = opt.multires ? Run(*multires, c, opt) : Run(*single, c, opt);
+        double const budget_us = static_cast<double>(c.block_size) / static_cast<double>(c.fs) * 1e6;
+        std::printf("%6zu %6.0f %6zu %5s %10.3f %9.1fx %10.2f %10.1f", c.block_size, static_cast<double>(c.fs),
+                    c.num_layers, c.phasy ? "on" : "off", r.ns_per_sample, r.realtime, r.p99_us, budget_us);
+        if (opt.sparse) std::printf(" %10.1f", r.skipped);
+        std::printf("\n");
+        std::fflush(stdout);
+        results.push_back(r);
+    }
+
+    if (opt.json_path != nullptr && !WriteJson(opt.json_path, opt, results)) {
+        std::fprintf(stderr, "can not write %s\n", opt.json_path);
+        return 2;
+    }
+
+    if (opt.baseline_path != nullptr) {
+        return Compare(baseline, results, opt.threshold) == 0 ? 0 : 1;
+    }
+    return 0;
+}
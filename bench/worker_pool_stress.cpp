@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "dsp/worker_pool.hpp"
+
+namespace {
+
+struct Options {
+    size_t num_workers{3};
+    size_t num_runs{1000000};
+    size_t max_jobs{32};
+};
+
+// every job of a run must be done once and only once before Run() returns, whatever the job count of the run
+// before it was
+struct Check {
+    std::vector<std::atomic<uint32_t>> hits;
+    std::vector<std::atomic<uint32_t>> busy_slots;
+    std::atomic<size_t> errors{};
+    uint32_t run{};
+
+    void operator()(size_t job, size_t slot) noexcept {
+        if (busy_slots[slot].fetch_add(1, std::memory_order_relaxed) != 0) {
+            errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        // stays around long enough for a late worker to sit between two runs
+        for (size_t i = 0; i < (job & 7); ++i) {
+            qwqdsp_parallel::CpuPause();
+        }
+        if (hits[job].exchange(run, std::memory_order_relaxed) == run) {
+            errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        busy_slots[slot].fetch_sub(1, std::memory_order_relaxed);
+    }
+};
+
+void PrintUsage() {
+    std::printf("usage: worker_pool_stress [--workers n] [--runs n] [--max-jobs n]\n");
+}
+
+bool ParseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) return false;
+        size_t const v = std::strtoull(argv[i + 1], nullptr, 10);
+        if (std::strcmp(argv[i], "--workers") == 0) opt.num_workers = v;
+        else if (std::strcmp(argv[i], "--runs") == 0) opt.num_runs = v;
+        else if (std::strcmp(argv[i], "--max-jobs") == 0) opt.max_jobs = std::clamp<size_t>(v, 2, 4096);
+        else return false;
+        ++i;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!ParseArgs(argc, argv, opt)) {
+        PrintUsage();
+        return 2;
+    }
+
+    qwqdsp_parallel::WorkerPool pool;
+    pool.Start(opt.num_workers);
+
+    Check check;
+    check.hits = std::vector<std::atomic<uint32_t>>(opt.max_jobs);
+    check.busy_slots = std::vector<std::atomic<uint32_t>>(pool.GetNumSlots());
+
+    // a small xorshift, the job count jumps up and down between runs like a toggled packed mode does
+    uint32_t rng = 0x9e3779b9u;
+    size_t missed = 0;
+    for (size_t r = 0; r < opt.num_runs; ++r) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        size_t const num_jobs = 2 + rng % (opt.max_jobs - 1);
+        check.run = static_cast<uint32_t>(r + 1);
+        pool.Run(num_jobs, check);
+        for (size_t j = 0; j < opt.max_jobs; ++j) {
+            bool const done = check.hits[j].load(std::memory_order_relaxed) == check.run;
+            if (done != (j < num_jobs)) ++missed;
+        }
+    }
+
+    size_t const errors = check.errors.load() + missed;
+    std::printf("%zu runs, %zu workers, up to %zu jobs, %zu errors\n", opt.num_runs, opt.num_workers,
+                opt.max_jobs, errors);
+    return errors == 0 ? 0 : 1;
+}
@@ -30,7 +30,8 @@
 *
 * - Real-complex FFT and complex-real inverse FFT for power-of-2-sized real data.
 *
-* - Uniform interface to different FFT implementations (currently Ooura, FFTW3 and Apple Accelerate).
+* - Uniform interface to different FFT implementations (currently Ooura, a built-in SIMD one, FFTW3,
+*   Intel IPP and Apple Accelerate).
 *
 * - Complex data is handled in "split-complex" format, i.e. there are separate
 *   arrays for the real and imaginary parts which can be useful for SIMD optimizations
@@ -42,10 +43,15 @@
 * - No allocations/deallocations after the initialization which makes it usable
 *   for real-time audio applications (that's what I wrote it for and using it).
 *
+* - The Ooura and the built-in SIMD implementation share their twiddle tables between
+*   all transforms of the same size in the process, every object only owns its work buffers.
+*
 *
 * How to use it in your project:
 *
-* - Add the .h and .cpp file to your project - that's all.
+* - Add the .h and .cpp file to your project - that's all. The backend is chosen
+*   at compile time and AudioFFT is a plain (final, non-virtual) alias for it, so
+*   the defines below have to be the same for every file including this header.
 *
 * - To get extra speed, you can link FFTW3 to your project and define
 *   AUDIOFFT_FFTW3 (however, please check whether your project suits the
@@ -56,6 +62,11 @@
 *   AUDIOFFT_APPLE_ACCELERATE  (however, please check whether your
 *   project suits the according license).
 *
+* - Without any of them the built-in SIMD implementation (SSE/AVX/NEON, in the
+*   style of PFFFT) is used. Define AUDIOFFT_OOURA to use the Ooura
+*   implementation instead, it runs in single precision unless
+*   AUDIOFFT_OOURA_DOUBLE is defined as well.
+*
 *
 * Remarks:
 *
@@ -87,8 +98,40 @@
 */
 
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 #include <cstddef>
+#include <cstring>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <vector>
+
+
+#if defined(AUDIOFFT_INTEL_IPP)
+  #define AUDIOFFT_INTEL_IPP_USED
+  #include <ipp.h>
+#elif defined(AUDIOFFT_APPLE_ACCELERATE)
+  #define AUDIOFFT_APPLE_ACCELERATE_USED
+  #include <Accelerate/Accelerate.h>
+#elif defined (AUDIOFFT_FFTW3)
+  #define AUDIOFFT_FFTW3_USED
+  #include <fftw3.h>
+#elif defined(AUDIOFFT_OOURA)
+  #define AUDIOFFT_OOURA_USED
+#else
+  #define AUDIOFFT_SIMD_USED
+#endif
+
+// Ooura and SimdFFT are self-contained and always available, only the selected one is used
+#if defined(__AVX__)
+  #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+  #include <arm_neon.h>
+#endif
 
 
 namespace audiofft
@@ -96,67 +139,1974 @@ namespace audiofft
 
   namespace detail
   {
-    class AudioFFTImpl;
-  }
 
+    constexpr bool IsPowerOf2(size_t val)
+    {
+      return (val == 1 || (val & (val-1)) == 0);
+    }
+
+
+    template<typename TypeDest, typename TypeSrc>
+    void ConvertBuffer(TypeDest* dest, const TypeSrc* src, size_t len)
+    {
+      for (size_t i=0; i<len; ++i)
+      {
+        dest[i] = static_cast<TypeDest>(src[i]);
+      }
+    }
+
+
+    template<typename TypeDest, typename TypeSrc, typename TypeFactor>
+    void ScaleBuffer(TypeDest* dest, const TypeSrc* src, const TypeFactor factor, size_t len)
+    {
+      for (size_t i=0; i<len; ++i)
+      {
+        dest[i] = static_cast<TypeDest>(static_cast<TypeFactor>(src[i]) * factor);
+      }
+    }
+
+
+    /**
+     * @internal
+     * @brief Process-wide registry of immutable plans, one per plan type and size
+     *
+     * The first init() of a size builds the plan, every later one of the same size gets the same
+     * object. A plan lives as long as a transform holds it and is built again after the last one
+     * let go of it. Thread-safe, but takes a lock and may allocate, like init() always did.
+     *
+     * @tparam Plan Constructible from the size, never changed after that
+     */
+    template<typename Plan>
+    std::shared_ptr<const Plan> GetSharedPlan(size_t size)
+    {
+      static std::mutex mutex;
+      static std::map<size_t, std::weak_ptr<const Plan>> plans;
+
+      std::lock_guard<std::mutex> lock(mutex);
+      std::weak_ptr<const Plan>& slot = plans[size];
+      std::shared_ptr<const Plan> plan = slot.lock();
+      if (!plan)
+      {
+        plan = std::make_shared<const Plan>(size);
+        slot = plan;
+      }
+      return plan;
+    }
+
+  } // End of namespace detail
 
-  // =============================================================
+
+  // ================================================================
 
 
   /**
-   * @class AudioFFT
-   * @brief Performs 1D FFTs
+   * @internal
+   * @class OouraFFT
+   * @brief FFT implementation based on the great radix-4 routines by Takuya Ooura
+   * @tparam T The type of the work buffer and twiddles, float avoids converting every
+   *           frame and halves the memory traffic, double is the original implementation
    */
-  class AudioFFT
+  template<typename T>
+  class OouraFFT final
   {
   public:
     /**
-     * @brief Constructor
+     * @brief The twiddles of a size, shared by every OouraFFT of that size
      */
-    AudioFFT();
+    struct Plan
+    {
+      explicit Plan(size_t size) :
+        w(size / 2),
+        cw(size / 2 + 1)
+      {
+        // ip is only scratch for the bit reversal here, every transform keeps its own
+        std::vector<int> ip(IpSize(size));
+        const int size4 = static_cast<int>(size) / 4;
+        makewt(size4, ip.data(), w.data());
+        makect(size4, ip.data(), w.data() + size4);
+        nw = ip[0];
+        nc = ip[1];
+        makewt(static_cast<int>(size) / 2, ip.data(), cw.data());
+      }
+
+      // the header Ooura keeps in ip[0] and ip[1]
+      int nw = 0;
+      int nc = 0;
+      std::vector<T> w;
+      // of the complex transform of the same size, twice as long
+      std::vector<T> cw;
+    };
+
+    OouraFFT() :
+      _size(0),
+      _plan(),
+      _ip(),
+      _buffer(),
+      _cip(),
+      _cbuffer()
+    {
+    }
 
-    AudioFFT(const AudioFFT&) = delete;
-    AudioFFT& operator=(const AudioFFT&) = delete;
+    OouraFFT(const OouraFFT&) = delete;
+    OouraFFT& operator=(const OouraFFT&) = delete;
 
     /**
-     * @brief Destructor
+     * @brief Calculates the necessary size of the real/imaginary complex arrays
+     * @param size The size of the real data
+     * @return The size of the real/imaginary complex arrays
      */
-    ~AudioFFT();
+    static size_t ComplexSize(size_t size)
+    {
+      return (size / 2) + 1;
+    }
+
+    void init(size_t size)
+    {
+      assert(detail::IsPowerOf2(size));
+      if (_size != size)
+      {
+        _plan = detail::GetSharedPlan<Plan>(size);
+        _size = size;
+
+        // the bit reversal writes its table to ip + 2 on every transform
+        _ip.assign(IpSize(size), 0);
+        _ip[0] = _plan->nw;
+        _ip[1] = _plan->nc;
+        _cip.assign(IpSize(size), 0);
+        _buffer.resize(size);
+        _cbuffer.resize(2 * size);
+      }
+    }
+
+    void fft(const float* data, float* re, float* im)
+    {
+      // Convert into the format as required by the Ooura FFT
+      detail::ConvertBuffer(_buffer.data(), data, _size);
+
+      rdft(static_cast<int>(_size), +1, _buffer.data(), _ip.data(), _plan->w.data());
+
+      // Convert back to split-complex
+      {
+        T* b = _buffer.data();
+        T* bEnd = b + _size;
+        float *r = re;
+        float *i = im;
+        while (b != bEnd)
+        {
+          *(r++) = static_cast<float>(*(b++));
+          *(i++) = static_cast<float>(-(*(b++)));
+        }
+      }
+      const size_t size2 = _size / 2;
+      re[size2] = -im[0];
+      im[0] = 0.0;
+      im[size2] = 0.0;
+    }
+
+    void ifft(float* data, const float* re, const float* im)
+    {
+      // Convert into the format as required by the Ooura FFT
+      {
+        T* b = _buffer.data();
+        T* bEnd = b + _size;
+        const float *r = re;
+        const float *i = im;
+        while (b != bEnd)
+        {
+          *(b++) = static_cast<T>(*(r++));
+          *(b++) = -static_cast<T>(*(i++));
+        }
+        _buffer[1] = re[_size / 2];
+      }
+
+      rdft(static_cast<int>(_size), -1, _buffer.data(), _ip.data(), _plan->w.data());
+
+      // Convert back to split-complex
+      detail::ScaleBuffer(data, _buffer.data(), static_cast<T>(2.0 / static_cast<double>(_size)), _size);
+    }
+
+    void cfft(const float* dataRe, const float* dataIm, float* re, float* im)
+    {
+      // Ooura's cdft uses exp(+j...), so transform the conjugate and conjugate back
+      {
+        T* b = _cbuffer.data();
+        for (size_t i=0; i<_size; ++i)
+        {
+          *(b++) = static_cast<T>(dataRe[i]);
+          *(b++) = -static_cast<T>(dataIm[i]);
+        }
+      }
+
+      cdft(static_cast<int>(2 * _size), _cbuffer.data(), _cip.data(), _plan->cw.data());
+
+      {
+        const T* b = _cbuffer.data();
+        for (size_t i=0; i<_size; ++i)
+        {
+          re[i] = static_cast<float>(*(b++));
+          im[i] = static_cast<float>(-(*(b++)));
+        }
+      }
+    }
+
+    void cifft(float* dataRe, float* dataIm, const float* re, const float* im)
+    {
+      {
+        T* b = _cbuffer.data();
+        for (size_t i=0; i<_size; ++i)
+        {
+          *(b++) = static_cast<T>(re[i]);
+          *(b++) = static_cast<T>(im[i]);
+        }
+      }
+
+      cdft(static_cast<int>(2 * _size), _cbuffer.data(), _cip.data(), _plan->cw.data());
+
+      {
+        const T scale = static_cast<T>(1.0 / static_cast<double>(_size));
+        const T* b = _cbuffer.data();
+        for (size_t i=0; i<_size; ++i)
+        {
+          dataRe[i] = static_cast<float>(*(b++) * scale);
+          dataIm[i] = static_cast<float>(*(b++) * scale);
+        }
+      }
+    }
+
+  private:
+    size_t _size;
+    std::shared_ptr<const Plan> _plan;
+    std::vector<int> _ip;
+    std::vector<T> _buffer;
+    std::vector<int> _cip;
+    std::vector<T> _cbuffer;
+
+    static size_t IpSize(size_t size)
+    {
+      return 2 + static_cast<size_t>(std::sqrt(static_cast<double>(size)));
+    }
+
+    static void cdft(int n, T *a, int *ip, const T *w)
+    {
+      if (n > 4)
+      {
+        bitrv2(n, ip + 2, a);
+        cftfsub(n, a, w);
+      }
+      else if (n == 4)
+      {
+        cftfsub(n, a, w);
+      }
+    }
+
+    static void rdft(int n, int isgn, T *a, int *ip, const T *w)
+    {
+      int nw = ip[0];
+      int nc = ip[1];
+
+      if (isgn >= 0)
+      {
+        if (n > 4)
+        {
+          bitrv2(n, ip + 2, a);
+          cftfsub(n, a, w);
+          rftfsub(n, a, nc, w + nw);
+        }
+        else if (n == 4)
+        {
+          cftfsub(n, a, w);
+        }
+        T xi = a[0] - a[1];
+        a[0] += a[1];
+        a[1] = xi;
+      }
+      else
+      {
+        a[1] = static_cast<T>(0.5) * (a[0] - a[1]);
+        a[0] -= a[1];
+        if (n > 4)
+        {
+          rftbsub(n, a, nc, w + nw);
+          bitrv2(n, ip + 2, a);
+          cftbsub(n, a, w);
+        }
+        else if (n == 4)
+        {
+          cftfsub(n, a, w);
+        }
+      }
+    }
+
+
+    /* -------- initializing routines -------- */
+
+    static void makewt(int nw, int *ip, T *w)
+    {
+      int j, nwh;
+      double delta, x, y;  // twiddles are always computed in double
+
+      ip[0] = nw;
+      ip[1] = 1;
+      if (nw > 2) {
+        nwh = nw >> 1;
+        delta = atan(1.0) / nwh;
+        w[0] = 1;
+        w[1] = 0;
+        w[nwh] = static_cast<T>(cos(delta * nwh));
+        w[nwh + 1] = w[nwh];
+        if (nwh > 2) {
+          for (j = 2; j < nwh; j += 2) {
+            x = cos(delta * j);
+            y = sin(delta * j);
+            w[j] = static_cast<T>(x);
+            w[j + 1] = static_cast<T>(y);
+            w[nw - j] = static_cast<T>(y);
+            w[nw - j + 1] = static_cast<T>(x);
+          }
+          bitrv2(nw, ip + 2, w);
+        }
+      }
+    }
+
+
+    static void makect(int nc, int *ip, T *c)
+    {
+      int j, nch;
+      double delta;
+
+      ip[1] = nc;
+      if (nc > 1) {
+        nch = nc >> 1;
+        delta = atan(1.0) / nch;
+        c[0] = static_cast<T>(cos(delta * nch));
+        c[nch] = static_cast<T>(0.5 * cos(delta * nch));
+        for (j = 1; j < nch; j++) {
+          c[j] = static_cast<T>(0.5 * cos(delta * j));
+          c[nc - j] = static_cast<T>(0.5 * sin(delta * j));
+        }
+      }
+    }
+
+
+    /* -------- child routines -------- */
+
+
+    static void bitrv2(int n, int *ip, T *a)
+    {
+      int j, j1, k, k1, l, m, m2;
+      T xr, xi, yr, yi;
+
+      ip[0] = 0;
+      l = n;
+      m = 1;
+      while ((m << 3) < l) {
+        l >>= 1;
+        for (j = 0; j < m; j++) {
+          ip[m + j] = ip[j] + l;
+        }
+        m <<= 1;
+      }
+      m2 = 2 * m;
+      if ((m << 3) == l) {
+        for (k = 0; k < m; k++) {
+          for (j = 0; j < k; j++) {
+            j1 = 2 * j + ip[k];
+            k1 = 2 * k + ip[j];
+            xr = a[j1];
+            xi = a[j1 + 1];
+            yr = a[k1];
+            yi = a[k1 + 1];
+            a[j1] = yr;
+            a[j1 + 1] = yi;
+            a[k1] = xr;
+            a[k1 + 1] = xi;
+            j1 += m2;
+            k1 += 2 * m2;
+            xr = a[j1];
+            xi = a[j1 + 1];
+            yr = a[k1];
+            yi = a[k1 + 1];
+            a[j1] = yr;
+            a[j1 + 1] = yi;
+            a[k1] = xr;
+            a[k1 + 1] = xi;
+            j1 += m2;
+            k1 -= m2;
+            xr = a[j1];
+            xi = a[j1 + 1];
+            yr = a[k1];
+            yi = a[k1 + 1];
+            a[j1] = yr;
+            a[j1 + 1] = yi;
+            a[k1] = xr;
+            a[k1 + 1] = xi;
+            j1 += m2;
+            k1 += 2 * m2;
+            xr = a[j1];
+            xi = a[j1 + 1];
+            yr = a[k1];
+            yi = a[k1 + 1];
+            a[j1] = yr;
+            a[j1 + 1] = yi;
+            a[k1] = xr;
+            a[k1 + 1] = xi;
+          }
+          j1 = 2 * k + m2 + ip[k];
+          k1 = j1 + m2;
+          xr = a[j1];
+          xi = a[j1 + 1];
+          yr = a[k1];
+          yi = a[k1 + 1];
+          a[j1] = yr;
+          a[j1 + 1] = yi;
+          a[k1] = xr;
+          a[k1 + 1] = xi;
+        }
+      } else {
+        for (k = 1; k < m; k++) {
+          for (j = 0; j < k; j++) {
+            j1 = 2 * j + ip[k];
+            k1 = 2 * k + ip[j];
+            xr = a[j1];
+            xi = a[j1 + 1];
+            yr = a[k1];
+            yi = a[k1 + 1];
+            a[j1] = yr;
+            a[j1 + 1] = yi;
+            a[k1] = xr;
+            a[k1 + 1] = xi;
+            j1 += m2;
+            k1 += m2;
+            xr = a[j1];
+            xi = a[j1 + 1];
+            yr = a[k1];
+            yi = a[k1 + 1];
+            a[j1] = yr;
+            a[j1 + 1] = yi;
+            a[k1] = xr;
+            a[k1 + 1] = xi;
+          }
+        }
+      }
+    }
+
+
+    static void cftfsub(int n, T *a, const T *w)
+    {
+      int j, j1, j2, j3, l;
+      T x0r, x0i, x1r, x1i, x2r, x2i, x3r, x3i;
+
+      l = 2;
+      if (n > 8) {
+        cft1st(n, a, w);
+        l = 8;
+        while ((l << 2) < n) {
+          cftmdl(n, l, a, w);
+          l <<= 2;
+        }
+      }
+      if ((l << 2) == n) {
+        for (j = 0; j < l; j += 2) {
+          j1 = j + l;
+          j2 = j1 + l;
+          j3 = j2 + l;
+          x0r = a[j] + a[j1];
+          x0i = a[j + 1] + a[j1 + 1];
+          x1r = a[j] - a[j1];
+          x1i = a[j + 1] - a[j1 + 1];
+          x2r = a[j2] + a[j3];
+          x2i = a[j2 + 1] + a[j3 + 1];
+          x3r = a[j2] - a[j3];
+          x3i = a[j2 + 1] - a[j3 + 1];
+          a[j] = x0r + x2r;
+          a[j + 1] = x0i + x2i;
+          a[j2] = x0r - x2r;
+          a[j2 + 1] = x0i - x2i;
+          a[j1] = x1r - x3i;
+          a[j1 + 1] = x1i + x3r;
+          a[j3] = x1r + x3i;
+          a[j3 + 1] = x1i - x3r;
+        }
+      } else {
+        for (j = 0; j < l; j += 2) {
+          j1 = j + l;
+          x0r = a[j] - a[j1];
+          x0i = a[j + 1] - a[j1 + 1];
+          a[j] += a[j1];
+          a[j + 1] += a[j1 + 1];
+          a[j1] = x0r;
+          a[j1 + 1] = x0i;
+        }
+      }
+    }
+
+
+    static void cftbsub(int n, T *a, const T *w)
+    {
+      int j, j1, j2, j3, l;
+      T x0r, x0i, x1r, x1i, x2r, x2i, x3r, x3i;
+
+      l = 2;
+      if (n > 8) {
+        cft1st(n, a, w);
+        l = 8;
+        while ((l << 2) < n) {
+          cftmdl(n, l, a, w);
+          l <<= 2;
+        }
+      }
+      if ((l << 2) == n) {
+        for (j = 0; j < l; j += 2) {
+          j1 = j + l;
+          j2 = j1 + l;
+          j3 = j2 + l;
+          x0r = a[j] + a[j1];
+          x0i = -a[j + 1] - a[j1 + 1];
+          x1r = a[j] - a[j1];
+          x1i = -a[j + 1] + a[j1 + 1];
+          x2r = a[j2] + a[j3];
+          x2i = a[j2 + 1] + a[j3 + 1];
+          x3r = a[j2] - a[j3];
+          x3i = a[j2 + 1] - a[j3 + 1];
+          a[j] = x0r + x2r;
+          a[j + 1] = x0i - x2i;
+          a[j2] = x0r - x2r;
+          a[j2 + 1] = x0i + x2i;
+          a[j1] = x1r - x3i;
+          a[j1 + 1] = x1i - x3r;
+          a[j3] = x1r + x3i;
+          a[j3 + 1] = x1i + x3r;
+        }
+      } else {
+        for (j = 0; j < l; j += 2) {
+          j1 = j + l;
+          x0r = a[j] - a[j1];
+          x0i = -a[j + 1] + a[j1 + 1];
+          a[j] += a[j1];
+          a[j + 1] = -a[j + 1] - a[j1 + 1];
+          a[j1] = x0r;
+          a[j1 + 1] = x0i;
+        }
+      }
+    }
+
+
+    static void cft1st(int n, T *a, const T *w)
+    {
+      int j, k1, k2;
+      T wk1r, wk1i, wk2r, wk2i, wk3r, wk3i;
+      T x0r, x0i, x1r, x1i, x2r, x2i, x3r, x3i;
+
+      x0r = a[0] + a[2];
+      x0i = a[1] + a[3];
+      x1r = a[0] - a[2];
+      x1i = a[1] - a[3];
+      x2r = a[4] + a[6];
+      x2i = a[5] + a[7];
+      x3r = a[4] - a[6];
+      x3i = a[5] - a[7];
+      a[0] = x0r + x2r;
+      a[1] = x0i + x2i;
+      a[4] = x0r - x2r;
+      a[5] = x0i - x2i;
+      a[2] = x1r - x3i;
+      a[3] = x1i + x3r;
+      a[6] = x1r + x3i;
+      a[7] = x1i - x3r;
+      wk1r = w[2];
+      x0r = a[8] + a[10];
+      x0i = a[9] + a[11];
+      x1r = a[8] - a[10];
+      x1i = a[9] - a[11];
+      x2r = a[12] + a[14];
+      x2i = a[13] + a[15];
+      x3r = a[12] - a[14];
+      x3i = a[13] - a[15];
+      a[8] = x0r + x2r;
+      a[9] = x0i + x2i;
+      a[12] = x2i - x0i;
+      a[13] = x0r - x2r;
+      x0r = x1r - x3i;
+      x0i = x1i + x3r;
+      a[10] = wk1r * (x0r - x0i);
+      a[11] = wk1r * (x0r + x0i);
+      x0r = x3i + x1r;
+      x0i = x3r - x1i;
+      a[14] = wk1r * (x0i - x0r);
+      a[15] = wk1r * (x0i + x0r);
+      k1 = 0;
+      for (j = 16; j < n; j += 16) {
+        k1 += 2;
+        k2 = 2 * k1;
+        wk2r = w[k1];
+        wk2i = w[k1 + 1];
+        wk1r = w[k2];
+        wk1i = w[k2 + 1];
+        wk3r = wk1r - 2 * wk2i * wk1i;
+        wk3i = 2 * wk2i * wk1r - wk1i;
+        x0r = a[j] + a[j + 2];
+        x0i = a[j + 1] + a[j + 3];
+        x1r = a[j] - a[j + 2];
+        x1i = a[j + 1] - a[j + 3];
+        x2r = a[j + 4] + a[j + 6];
+        x2i = a[j + 5] + a[j + 7];
+        x3r = a[j + 4] - a[j + 6];
+        x3i = a[j + 5] - a[j + 7];
+        a[j] = x0r + x2r;
+        a[j + 1] = x0i + x2i;
+        x0r -= x2r;
+        x0i -= x2i;
+        a[j + 4] = wk2r * x0r - wk2i * x0i;
+        a[j + 5] = wk2r * x0i + wk2i * x0r;
+        x0r = x1r - x3i;
+        x0i = x1i + x3r;
+        a[j + 2] = wk1r * x0r - wk1i * x0i;
+        a[j + 3] = wk1r * x0i + wk1i * x0r;
+        x0r = x1r + x3i;
+        x0i = x1i - x3r;
+        a[j + 6] = wk3r * x0r - wk3i * x0i;
+        a[j + 7] = wk3r * x0i + wk3i * x0r;
+        wk1r = w[k2 + 2];
+        wk1i = w[k2 + 3];
+        wk3r = wk1r - 2 * wk2r * wk1i;
+        wk3i = 2 * wk2r * wk1r - wk1i;
+        x0r = a[j + 8] + a[j + 10];
+        x0i = a[j + 9] + a[j + 11];
+        x1r = a[j + 8] - a[j + 10];
+        x1i = a[j + 9] - a[j + 11];
+        x2r = a[j + 12] + a[j + 14];
+        x2i = a[j + 13] + a[j + 15];
+        x3r = a[j + 12] - a[j + 14];
+        x3i = a[j + 13] - a[j + 15];
+        a[j + 8] = x0r + x2r;
+        a[j + 9] = x0i + x2i;
+        x0r -= x2r;
+        x0i -= x2i;
+        a[j + 12] = -wk2i * x0r - wk2r * x0i;
+        a[j + 13] = -wk2i * x0i + wk2r * x0r;
+        x0r = x1r - x3i;
+        x0i = x1i + x3r;
+        a[j + 10] = wk1r * x0r - wk1i * x0i;
+        a[j + 11] = wk1r * x0i + wk1i * x0r;
+        x0r = x1r + x3i;
+        x0i = x1i - x3r;
+        a[j + 14] = wk3r * x0r - wk3i * x0i;
+        a[j + 15] = wk3r * x0i + wk3i * x0r;
+      }
+    }
+
+
+    static void cftmdl(int n, int l, T *a, const T *w)
+    {
+      int j, j1, j2, j3, k, k1, k2, m, m2;
+      T wk1r, wk1i, wk2r, wk2i, wk3r, wk3i;
+      T x0r, x0i, x1r, x1i, x2r, x2i, x3r, x3i;
+
+      m = l << 2;
+      for (j = 0; j < l; j += 2) {
+        j1 = j + l;
+        j2 = j1 + l;
+        j3 = j2 + l;
+        x0r = a[j] + a[j1];
+        x0i = a[j + 1] + a[j1 + 1];
+        x1r = a[j] - a[j1];
+        x1i = a[j + 1] - a[j1 + 1];
+        x2r = a[j2] + a[j3];
+        x2i = a[j2 + 1] + a[j3 + 1];
+        x3r = a[j2] - a[j3];
+        x3i = a[j2 + 1] - a[j3 + 1];
+        a[j] = x0r + x2r;
+        a[j + 1] = x0i + x2i;
+        a[j2] = x0r - x2r;
+        a[j2 + 1] = x0i - x2i;
+        a[j1] = x1r - x3i;
+        a[j1 + 1] = x1i + x3r;
+        a[j3] = x1r + x3i;
+        a[j3 + 1] = x1i - x3r;
+      }
+      wk1r = w[2];
+      for (j = m; j < l + m; j += 2) {
+        j1 = j + l;
+        j2 = j1 + l;
+        j3 = j2 + l;
+        x0r = a[j] + a[j1];
+        x0i = a[j + 1] + a[j1 + 1];
+        x1r = a[j] - a[j1];
+        x1i = a[j + 1] - a[j1 + 1];
+        x2r = a[j2] + a[j3];
+        x2i = a[j2 + 1] + a[j3 + 1];
+        x3r = a[j2] - a[j3];
+        x3i = a[j2 + 1] - a[j3 + 1];
+        a[j] = x0r + x2r;
+        a[j + 1] = x0i + x2i;
+        a[j2] = x2i - x0i;
+        a[j2 + 1] = x0r - x2r;
+        x0r = x1r - x3i;
+        x0i = x1i + x3r;
+        a[j1] = wk1r * (x0r - x0i);
+        a[j1 + 1] = wk1r * (x0r + x0i);
+        x0r = x3i + x1r;
+        x0i = x3r - x1i;
+        a[j3] = wk1r * (x0i - x0r);
+        a[j3 + 1] = wk1r * (x0i + x0r);
+      }
+      k1 = 0;
+      m2 = 2 * m;
+      for (k = m2; k < n; k += m2) {
+        k1 += 2;
+        k2 = 2 * k1;
+        wk2r = w[k1];
+        wk2i = w[k1 + 1];
+        wk1r = w[k2];
+        wk1i = w[k2 + 1];
+        wk3r = wk1r - 2 * wk2i * wk1i;
+        wk3i = 2 * wk2i * wk1r - wk1i;
+        for (j = k; j < l + k; j += 2) {
+          j1 = j + l;
+          j2 = j1 + l;
+          j3 = j2 + l;
+          x0r = a[j] + a[j1];
+          x0i = a[j + 1] + a[j1 + 1];
+          x1r = a[j] - a[j1];
+          x1i = a[j + 1] - a[j1 + 1];
+          x2r = a[j2] + a[j3];
+          x2i = a[j2 + 1] + a[j3 + 1];
+          x3r = a[j2] - a[j3];
+          x3i = a[j2 + 1] - a[j3 + 1];
+          a[j] = x0r + x2r;
+          a[j + 1] = x0i + x2i;
+          x0r -= x2r;
+          x0i -= x2i;
+          a[j2] = wk2r * x0r - wk2i * x0i;
+          a[j2 + 1] = wk2r * x0i + wk2i * x0r;
+          x0r = x1r - x3i;
+          x0i = x1i + x3r;
+          a[j1] = wk1r * x0r - wk1i * x0i;
+          a[j1 + 1] = wk1r * x0i + wk1i * x0r;
+          x0r = x1r + x3i;
+          x0i = x1i - x3r;
+          a[j3] = wk3r * x0r - wk3i * x0i;
+          a[j3 + 1] = wk3r * x0i + wk3i * x0r;
+        }
+        wk1r = w[k2 + 2];
+        wk1i = w[k2 + 3];
+        wk3r = wk1r - 2 * wk2r * wk1i;
+        wk3i = 2 * wk2r * wk1r - wk1i;
+        for (j = k + m; j < l + (k + m); j += 2) {
+          j1 = j + l;
+          j2 = j1 + l;
+          j3 = j2 + l;
+          x0r = a[j] + a[j1];
+          x0i = a[j + 1] + a[j1 + 1];
+          x1r = a[j] - a[j1];
+          x1i = a[j + 1] - a[j1 + 1];
+          x2r = a[j2] + a[j3];
+          x2i = a[j2 + 1] + a[j3 + 1];
+          x3r = a[j2] - a[j3];
+          x3i = a[j2 + 1] - a[j3 + 1];
+          a[j] = x0r + x2r;
+          a[j + 1] = x0i + x2i;
+          x0r -= x2r;
+          x0i -= x2i;
+          a[j2] = -wk2i * x0r - wk2r * x0i;
+          a[j2 + 1] = -wk2i * x0i + wk2r * x0r;
+          x0r = x1r - x3i;
+          x0i = x1i + x3r;
+          a[j1] = wk1r * x0r - wk1i * x0i;
+          a[j1 + 1] = wk1r * x0i + wk1i * x0r;
+          x0r = x1r + x3i;
+          x0i = x1i - x3r;
+          a[j3] = wk3r * x0r - wk3i * x0i;
+          a[j3 + 1] = wk3r * x0i + wk3i * x0r;
+        }
+      }
+    }
+
+
+    static void rftfsub(int n, T *a, int nc, const T *c)
+    {
+      int j, k, kk, ks, m;
+      T wkr, wki, xr, xi, yr, yi;
+
+      m = n >> 1;
+      ks = 2 * nc / m;
+      kk = 0;
+      for (j = 2; j < m; j += 2) {
+        k = n - j;
+        kk += ks;
+        wkr = static_cast<T>(0.5) - c[nc - kk];
+        wki = c[kk];
+        xr = a[j] - a[k];
+        xi = a[j + 1] + a[k + 1];
+        yr = wkr * xr - wki * xi;
+        yi = wkr * xi + wki * xr;
+        a[j] -= yr;
+        a[j + 1] -= yi;
+        a[k] += yr;
+        a[k + 1] -= yi;
+      }
+    }
+
+
+    static void rftbsub(int n, T *a, int nc, const T *c)
+    {
+      int j, k, kk, ks, m;
+      T wkr, wki, xr, xi, yr, yi;
+
+      a[1] = -a[1];
+      m = n >> 1;
+      ks = 2 * nc / m;
+      kk = 0;
+      for (j = 2; j < m; j += 2) {
+        k = n - j;
+        kk += ks;
+        wkr = static_cast<T>(0.5) - c[nc - kk];
+        wki = c[kk];
+        xr = a[j] - a[k];
+        xi = a[j + 1] + a[k + 1];
+        yr = wkr * xr + wki * xi;
+        yi = wkr * xi - wki * xr;
+        a[j] -= yr;
+        a[j + 1] = yi - a[j + 1];
+        a[k] += yr;
+        a[k + 1] = yi - a[k + 1];
+      }
+      a[m + 1] = -a[m + 1];
+    }
+  };
+
+
+  // ================================================================
+
+
+  namespace detail
+  {
 
     /**
-     * @brief Initializes the FFT object
-     * @param size Size of the real input (must be power 2)
+     * @internal
+     * @brief Minimal vector types for SimdFFT, one lane per float
      */
-    void init(size_t size);
+    namespace simd
+    {
+
+      struct Scalar
+      {
+        typedef float Type;
+        static constexpr size_t Width = 1;
+        static Type Load(const float* p) { return *p; }
+        static void Store(float* p, Type x) { *p = x; }
+        static Type Set(float x) { return x; }
+        static Type Add(Type a, Type b) { return a + b; }
+        static Type Sub(Type a, Type b) { return a - b; }
+        static Type Mul(Type a, Type b) { return a * b; }
+        static void Transpose(Type*) {}
+      };
+
+#if defined(__AVX__)
+
+      struct Avx
+      {
+        typedef __m256 Type;
+        static constexpr size_t Width = 8;
+        static Type Load(const float* p) { return _mm256_loadu_ps(p); }
+        static void Store(float* p, Type x) { _mm256_storeu_ps(p, x); }
+        static Type Set(float x) { return _mm256_set1_ps(x); }
+        static Type Add(Type a, Type b) { return _mm256_add_ps(a, b); }
+        static Type Sub(Type a, Type b) { return _mm256_sub_ps(a, b); }
+        static Type Mul(Type a, Type b) { return _mm256_mul_ps(a, b); }
+
+        static void Transpose(Type* r)
+        {
+          const __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]);
+          const __m256 t1 = _mm256_unpackhi_ps(r[0], r[1]);
+          const __m256 t2 = _mm256_unpacklo_ps(r[2], r[3]);
+          const __m256 t3 = _mm256_unpackhi_ps(r[2], r[3]);
+          const __m256 t4 = _mm256_unpacklo_ps(r[4], r[5]);
+          const __m256 t5 = _mm256_unpackhi_ps(r[4], r[5]);
+          const __m256 t6 = _mm256_unpacklo_ps(r[6], r[7]);
+          const __m256 t7 = _mm256_unpackhi_ps(r[6], r[7]);
+          const __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+          const __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+          const __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+          const __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+          const __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+          const __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+          const __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+          const __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+          r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+          r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+          r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+          r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+          r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+          r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+          r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+          r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+        }
+      };
+      typedef Avx Native;
+
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+      struct Sse
+      {
+        typedef __m128 Type;
+        static constexpr size_t Width = 4;
+        static Type Load(const float* p) { return _mm_loadu_ps(p); }
+        static void Store(float* p, Type x) { _mm_storeu_ps(p, x); }
+        static Type Set(float x) { return _mm_set1_ps(x); }
+        static Type Add(Type a, Type b) { return _mm_add_ps(a, b); }
+        static Type Sub(Type a, Type b) { return _mm_sub_ps(a, b); }
+        static Type Mul(Type a, Type b) { return _mm_mul_ps(a, b); }
+
+        static void Transpose(Type* r)
+        {
+          _MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+        }
+      };
+      typedef Sse Native;
+
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+
+      struct Neon
+      {
+        typedef float32x4_t Type;
+        static constexpr size_t Width = 4;
+        static Type Load(const float* p) { return vld1q_f32(p); }
+        static void Store(float* p, Type x) { vst1q_f32(p, x); }
+        static Type Set(float x) { return vdupq_n_f32(x); }
+        static Type Add(Type a, Type b) { return vaddq_f32(a, b); }
+        static Type Sub(Type a, Type b) { return vsubq_f32(a, b); }
+        static Type Mul(Type a, Type b) { return vmulq_f32(a, b); }
+
+        static void Transpose(Type* r)
+        {
+          const float32x4x2_t t01 = vtrnq_f32(r[0], r[1]);
+          const float32x4x2_t t23 = vtrnq_f32(r[2], r[3]);
+          r[0] = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+          r[1] = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+          r[2] = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+          r[3] = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+        }
+      };
+      typedef Neon Native;
+
+#else
+
+      typedef Scalar Native;
+
+#endif
+
+    } // End of namespace simd
+
 
     /**
-     * @brief Performs the forward FFT
-     * @param data The real input data (has to be of the length as specified in init())
-     * @param re The real part of the complex output (has to be of length as returned by ComplexSize())
-     * @param im The imaginary part of the complex output (has to be of length as returned by ComplexSize())
+     * @internal
+     * @brief Forward complex FFT of split-complex data, vectorized "four-step" style like PFFFT
+     *
+     * The size N = W * M is seen as W interleaved sequences x[n1 + W * n2] of length M, one per
+     * lane. First all lanes run the same radix-4 (and radix-2) Stockham M-point FFT, which only
+     * needs vertical vector ops. Then each lane is multiplied by W_N^(n1 * k2) and the W-point
+     * DFTs across the lanes are done after a W x W transpose, which also leaves the result in
+     * natural order. Requires N >= W * W.
      */
-    void fft(const float* data, float* re, float* im);
+    template<typename V>
+    class StockhamFFT
+    {
+    public:
+      typedef typename V::Type Type;
+      static constexpr size_t Width = V::Width;
+
+      /**
+       * @brief The twiddles of a size, shared by every StockhamFFT of that size and width
+       */
+      struct Plan
+      {
+        explicit Plan(size_t size) :
+          laneTwiddleRe(size),
+          laneTwiddleIm(size)
+        {
+          const double pi = 3.14159265358979323846;
+          const size_t numVectors = size / Width;
+          for (size_t n=numVectors; n>=4; n/=4)
+          {
+            for (size_t p=0; p<n/4; ++p)
+            {
+              for (size_t r=1; r<=3; ++r)
+              {
+                const double phase = -2.0 * pi * static_cast<double>(r * p) / static_cast<double>(n);
+                stageTwiddles.push_back(static_cast<float>(std::cos(phase)));
+                stageTwiddles.push_back(static_cast<float>(std::sin(phase)));
+              }
+            }
+          }
+
+          for (size_t k=0; k<numVectors; ++k)
+          {
+            for (size_t lane=0; lane<Width; ++lane)
+            {
+              const double phase = -2.0 * pi * static_cast<double>((lane * k) % size) / static_cast<double>(size);
+              laneTwiddleRe[k * Width + lane] = static_cast<float>(std::cos(phase));
+              laneTwiddleIm[k * Width + lane] = static_cast<float>(std::sin(phase));
+            }
+          }
+        }
+
+        std::vector<float> stageTwiddles;
+        std::vector<float> laneTwiddleRe;
+        std::vector<float> laneTwiddleIm;
+      };
+
+      void init(size_t size)
+      {
+        _size = size;
+        _numVectors = size / Width;
+        _plan = GetSharedPlan<Plan>(size);
+
+        for (size_t i=0; i<2; ++i)
+        {
+          _workRe[i].resize(size);
+          _workIm[i].resize(size);
+        }
+      }
+
+      /**
+       * @brief Unscaled forward transform, the output may alias the input
+       */
+      void forward(const float* xr, const float* xi, float* yr, float* yi)
+      {
+        const float* srcRe = xr;
+        const float* srcIm = xi;
+        size_t work = 0;
+        const float* twiddles = _plan->stageTwiddles.data();
+
+        size_t n = _numVectors;
+        size_t s = 1;
+        while (n >= 4)
+        {
+          float* dstRe = _workRe[work].data();
+          float* dstIm = _workIm[work].data();
+          radix4(n, s, srcRe, srcIm, dstRe, dstIm, twiddles);
+          twiddles += 6 * (n / 4);
+          srcRe = dstRe;
+          srcIm = dstIm;
+          work ^= 1;
+          n /= 4;
+          s *= 4;
+        }
+        if (n == 2)
+        {
+          float* dstRe = _workRe[work].data();
+          float* dstIm = _workIm[work].data();
+          radix2(s, srcRe, srcIm, dstRe, dstIm);
+          srcRe = dstRe;
+          srcIm = dstIm;
+        }
+
+        acrossLanes(srcRe, srcIm, yr, yi);
+      }
+
+    private:
+      static void cmul(Type& re, Type& im, Type wr, Type wi)
+      {
+        const Type r = V::Sub(V::Mul(re, wr), V::Mul(im, wi));
+        im = V::Add(V::Mul(re, wi), V::Mul(im, wr));
+        re = r;
+      }
+
+      // y[q + s(4p + r)] = W_n^(rp) * DFT4(x[q + s(p + r n/4)])
+      static void radix4(size_t n, size_t s, const float* xr, const float* xi, float* yr, float* yi, const float* tw)
+      {
+        const size_t m = n / 4;
+        for (size_t p=0; p<m; ++p)
+        {
+          const bool rotate = (p != 0);
+          const Type w1r = V::Set(tw[6 * p + 0]);
+          const Type w1i = V::Set(tw[6 * p + 1]);
+          const Type w2r = V::Set(tw[6 * p + 2]);
+          const Type w2i = V::Set(tw[6 * p + 3]);
+          const Type w3r = V::Set(tw[6 * p + 4]);
+          const Type w3i = V::Set(tw[6 * p + 5]);
+          for (size_t q=0; q<s; ++q)
+          {
+            const size_t ia = (q + s * p) * Width;
+            const size_t ib = ia + s * m * Width;
+            const size_t ic = ib + s * m * Width;
+            const size_t id = ic + s * m * Width;
+            const Type ar = V::Load(xr + ia), ai = V::Load(xi + ia);
+            const Type br = V::Load(xr + ib), bi = V::Load(xi + ib);
+            const Type cr = V::Load(xr + ic), ci = V::Load(xi + ic);
+            const Type dr = V::Load(xr + id), di = V::Load(xi + id);
+
+            const Type apcR = V::Add(ar, cr), apcI = V::Add(ai, ci);
+            const Type amcR = V::Sub(ar, cr), amcI = V::Sub(ai, ci);
+            const Type bpdR = V::Add(br, dr), bpdI = V::Add(bi, di);
+            const Type bmdR = V::Sub(br, dr), bmdI = V::Sub(bi, di);
+
+            Type y0r = V::Add(apcR, bpdR), y0i = V::Add(apcI, bpdI);
+            Type y1r = V::Add(amcR, bmdI), y1i = V::Sub(amcI, bmdR);
+            Type y2r = V::Sub(apcR, bpdR), y2i = V::Sub(apcI, bpdI);
+            Type y3r = V::Sub(amcR, bmdI), y3i = V::Add(amcI, bmdR);
+            if (rotate)
+            {
+              cmul(y1r, y1i, w1r, w1i);
+              cmul(y2r, y2i, w2r, w2i);
+              cmul(y3r, y3i, w3r, w3i);
+            }
+
+            const size_t oa = (q + s * 4 * p) * Width;
+            const size_t ob = oa + s * Width;
+            const size_t oc = ob + s * Width;
+            const size_t od = oc + s * Width;
+            V::Store(yr + oa, y0r); V::Store(yi + oa, y0i);
+            V::Store(yr + ob, y1r); V::Store(yi + ob, y1i);
+            V::Store(yr + oc, y2r); V::Store(yi + oc, y2i);
+            V::Store(yr + od, y3r); V::Store(yi + od, y3i);
+          }
+        }
+      }
+
+      // last stage of an odd power of two, no twiddles left
+      static void radix2(size_t s, const float* xr, const float* xi, float* yr, float* yi)
+      {
+        for (size_t q=0; q<s; ++q)
+        {
+          const size_t ia = q * Width;
+          const size_t ib = ia + s * Width;
+          const Type ar = V::Load(xr + ia), ai = V::Load(xi + ia);
+          const Type br = V::Load(xr + ib), bi = V::Load(xi + ib);
+          V::Store(yr + ia, V::Add(ar, br));
+          V::Store(yi + ia, V::Add(ai, bi));
+          V::Store(yr + ib, V::Sub(ar, br));
+          V::Store(yi + ib, V::Sub(ai, bi));
+        }
+      }
+
+      static void dft4(Type* re, Type* im)
+      {
+        const Type apcR = V::Add(re[0], re[2]), apcI = V::Add(im[0], im[2]);
+        const Type amcR = V::Sub(re[0], re[2]), amcI = V::Sub(im[0], im[2]);
+        const Type bpdR = V::Add(re[1], re[3]), bpdI = V::Add(im[1], im[3]);
+        const Type bmdR = V::Sub(re[1], re[3]), bmdI = V::Sub(im[1], im[3]);
+        re[0] = V::Add(apcR, bpdR); im[0] = V::Add(apcI, bpdI);
+        re[1] = V::Add(amcR, bmdI); im[1] = V::Sub(amcI, bmdR);
+        re[2] = V::Sub(apcR, bpdR); im[2] = V::Sub(apcI, bpdI);
+        re[3] = V::Sub(amcR, bmdI); im[3] = V::Add(amcI, bmdR);
+      }
+
+      static void dft8(Type* re, Type* im)
+      {
+        Type er[4] = { re[0], re[2], re[4], re[6] };
+        Type ei[4] = { im[0], im[2], im[4], im[6] };
+        Type orr[4] = { re[1], re[3], re[5], re[7] };
+        Type oi[4] = { im[1], im[3], im[5], im[7] };
+        dft4(er, ei);
+        dft4(orr, oi);
+
+        // W_8^1 = c - jc, W_8^2 = -j, W_8^3 = -c - jc
+        const Type c = V::Set(0.70710678118654752f);
+        const Type o1r = V::Mul(c, V::Add(orr[1], oi[1]));
+        const Type o1i = V::Mul(c, V::Sub(oi[1], orr[1]));
+        const Type o2r = oi[2];
+        const Type o2i = V::Sub(V::Set(0.0f), orr[2]);
+        const Type o3r = V::Mul(c, V::Sub(oi[3], orr[3]));
+        const Type o3i = V::Mul(V::Set(-0.70710678118654752f), V::Add(orr[3], oi[3]));
+
+        re[0] = V::Add(er[0], orr[0]); im[0] = V::Add(ei[0], oi[0]);
+        re[4] = V::Sub(er[0], orr[0]); im[4] = V::Sub(ei[0], oi[0]);
+        re[1] = V::Add(er[1], o1r); im[1] = V::Add(ei[1], o1i);
+        re[5] = V::Sub(er[1], o1r); im[5] = V::Sub(ei[1], o1i);
+        re[2] = V::Add(er[2], o2r); im[2] = V::Add(ei[2], o2i);
+        re[6] = V::Sub(er[2], o2r); im[6] = V::Sub(ei[2], o2i);
+        re[3] = V::Add(er[3], o3r); im[3] = V::Add(ei[3], o3i);
+        re[7] = V::Sub(er[3], o3r); im[7] = V::Sub(ei[3], o3i);
+      }
+
+      // X[M k1 + k2] = sum_n1 W_W^(n1 k1) * W_N^(n1 k2) * Y_n1[k2]
+      void acrossLanes(const float* xr, const float* xi, float* yr, float* yi) const
+      {
+        const float* twr = _plan->laneTwiddleRe.data();
+        const float* twi = _plan->laneTwiddleIm.data();
+        for (size_t block=0; block<_numVectors; block+=Width)
+        {
+          Type re[Width];
+          Type im[Width];
+          for (size_t j=0; j<Width; ++j)
+          {
+            const size_t offset = (block + j) * Width;
+            re[j] = V::Load(xr + offset);
+            im[j] = V::Load(xi + offset);
+            cmul(re[j], im[j], V::Load(twr + offset), V::Load(twi + offset));
+          }
+          V::Transpose(re);
+          V::Transpose(im);
+          if constexpr (Width == 4)
+          {
+            dft4(re, im);
+          }
+          else if constexpr (Width == 8)
+          {
+            dft8(re, im);
+          }
+          for (size_t k1=0; k1<Width; ++k1)
+          {
+            V::Store(yr + k1 * _numVectors + block, re[k1]);
+            V::Store(yi + k1 * _numVectors + block, im[k1]);
+          }
+        }
+      }
+
+      size_t _size = 0;
+      size_t _numVectors = 0;
+      std::shared_ptr<const Plan> _plan;
+      std::vector<float> _workRe[2];
+      std::vector<float> _workIm[2];
+    };
+
 
     /**
-     * @brief Performs the inverse FFT
-     * @param data The real output data (has to be of the length as specified in init())
-     * @param re The real part of the complex input (has to be of length as returned by ComplexSize())
-     * @param im The imaginary part of the complex input (has to be of length as returned by ComplexSize())
+     * @internal
+     * @brief StockhamFFT on the native vector width, or on scalars if the size is too small for it
      */
-    void ifft(float* data, const float* re, const float* im);
+    class ComplexFFT
+    {
+    public:
+      void init(size_t size)
+      {
+        _vectorized = (size >= simd::Native::Width * simd::Native::Width);
+        if (_vectorized)
+        {
+          _vector.init(size);
+        }
+        else
+        {
+          _scalar.init(size);
+        }
+      }
+
+      void forward(const float* xr, const float* xi, float* yr, float* yi)
+      {
+        if (_vectorized)
+        {
+          _vector.forward(xr, xi, yr, yi);
+        }
+        else
+        {
+          _scalar.forward(xr, xi, yr, yi);
+        }
+      }
+
+    private:
+      bool _vectorized = false;
+      StockhamFFT<simd::Native> _vector;
+      StockhamFFT<simd::Scalar> _scalar;
+    };
+
+  } // End of namespace detail
+
+
+  /**
+   * @internal
+   * @class SimdFFT
+   * @brief Self-contained SSE/AVX/NEON implementation in the style of PFFFT
+   *
+   * A real FFT of size N is a complex FFT of size N/2 on the even (real part) and odd
+   * (imaginary part) samples, followed by the usual split into the two half spectra.
+   */
+  class SimdFFT final
+  {
+  public:
+    /**
+     * @brief The split twiddles W_N^k of a size, shared by every SimdFFT of that size
+     */
+    struct Plan
+    {
+      explicit Plan(size_t size) :
+        twiddleRe(size / 4 + 1),
+        twiddleIm(size / 4 + 1)
+      {
+        const double pi = 3.14159265358979323846;
+        for (size_t k=0; k<=size/4; ++k)
+        {
+          const double phase = -2.0 * pi * static_cast<double>(k) / static_cast<double>(size);
+          twiddleRe[k] = static_cast<float>(std::cos(phase));
+          twiddleIm[k] = static_cast<float>(std::sin(phase));
+        }
+      }
+
+      std::vector<float> twiddleRe;
+      std::vector<float> twiddleIm;
+    };
+
+    SimdFFT() = default;
+
+    SimdFFT(const SimdFFT&) = delete;
+    SimdFFT& operator=(const SimdFFT&) = delete;
+
+    /**
+     * @brief Calculates the necessary size of the real/imaginary complex arrays
+     * @param size The size of the real data
+     * @return The size of the real/imaginary complex arrays
+     */
+    static size_t ComplexSize(size_t size)
+    {
+      return (size / 2) + 1;
+    }
+
+    void init(size_t size)
+    {
+      assert(detail::IsPowerOf2(size));
+      if (_size != size)
+      {
+        const size_t half = size / 2;
+        _size = size;
+        _half.init(std::max<size_t>(half, 1));
+        _full.init(size);
+        _re.resize(half + 1);
+        _im.resize(half + 1);
+        _plan = detail::GetSharedPlan<Plan>(size);
+      }
+    }
+
+    void fft(const float* data, float* re, float* im)
+    {
+      const size_t half = _size / 2;
+      for (size_t i=0; i<half; ++i)
+      {
+        _re[i] = data[2 * i];
+        _im[i] = data[2 * i + 1];
+      }
+      _half.forward(_re.data(), _im.data(), _re.data(), _im.data());
+
+      // X[k] = E[k] + W_N^k O[k], with E = (Z[k] + Z*[H-k]) / 2 and O = -j (Z[k] - Z*[H-k]) / 2
+      re[0] = _re[0] + _im[0];
+      im[0] = 0.0f;
+      re[half] = _re[0] - _im[0];
+      im[half] = 0.0f;
+      for (size_t k=1; k<=half/2; ++k)
+      {
+        const size_t l = half - k;
+        const float er = 0.5f * (_re[k] + _re[l]);
+        const float ei = 0.5f * (_im[k] - _im[l]);
+        const float orr = 0.5f * (_im[k] + _im[l]);
+        const float oi = -0.5f * (_re[k] - _re[l]);
+        const float wr = _plan->twiddleRe[k];
+        const float wi = _plan->twiddleIm[k];
+        const float tr = wr * orr - wi * oi;
+        const float ti = wr * oi + wi * orr;
+        re[k] = er + tr;
+        im[k] = ei + ti;
+        // the mirrored bin uses W_N^(H-k) = -conj(W_N^k)
+        re[l] = er - tr;
+        im[l] = ti - ei;
+      }
+    }
+
+    void ifft(float* data, const float* re, const float* im)
+    {
+      const size_t half = _size / 2;
+      const float scale = 1.0f / static_cast<float>(_size);
+
+      // Z[k] = E[k] + j O[k], E = (X[k] + X*[H-k]) / 2, O = W_N^-k (X[k] - X*[H-k]) / 2,
+      // conjugated (swapped) for the inverse and with the 1 / (N/2) scaling folded in
+      _re[0] = (re[0] - re[half]) * scale;
+      _im[0] = (re[0] + re[half]) * scale;
+      for (size_t k=1; k<=half/2; ++k)
+      {
+        const size_t l = half - k;
+        const float er = re[k] + re[l];
+        const float ei = im[k] - im[l];
+        const float dr = re[k] - re[l];
+        const float di = im[k] + im[l];
+        const float wr = _plan->twiddleRe[k];
+        const float wi = -_plan->twiddleIm[k];
+        const float orr = dr * wr - di * wi;
+        const float oi = dr * wi + di * wr;
+        // Z[k] = E + jO, Z[H-k] = E* + jO*
+        _im[k] = (er - oi) * scale;
+        _re[k] = (ei + orr) * scale;
+        _im[l] = (er + oi) * scale;
+        _re[l] = (orr - ei) * scale;
+      }
+      // forward transform of the swapped spectrum is the swapped inverse transform
+      _half.forward(_re.data(), _im.data(), _re.data(), _im.data());
+      for (size_t i=0; i<half; ++i)
+      {
+        data[2 * i] = _im[i];
+        data[2 * i + 1] = _re[i];
+      }
+    }
+
+    void cfft(const float* dataRe, const float* dataIm, float* re, float* im)
+    {
+      _full.forward(dataRe, dataIm, re, im);
+    }
+
+    void cifft(float* dataRe, float* dataIm, const float* re, const float* im)
+    {
+      _full.forward(im, re, dataIm, dataRe);
+      const float scale = 1.0f / static_cast<float>(_size);
+      for (size_t i=0; i<_size; ++i)
+      {
+        dataRe[i] *= scale;
+        dataIm[i] *= scale;
+      }
+    }
+
+  private:
+    size_t _size = 0;
+    detail::ComplexFFT _half;
+    detail::ComplexFFT _full;
+    std::vector<float> _re;
+    std::vector<float> _im;
+    std::shared_ptr<const Plan> _plan;
+  };
+
+
+
+  // ================================================================
+
+
+#ifdef AUDIOFFT_INTEL_IPP_USED
+
+
+  /**
+   * @internal
+   * @class IntelIppFFT
+   * @brief FFT implementation using the Intel Integrated Performance Primitives
+   */
+  class IntelIppFFT final
+  {
+  public:
+    IntelIppFFT() :
+      _size(0),
+      _operationalBufferSize(0),
+      _powerOf2(0),
+      _fftSpec(nullptr),
+      _fftSpecBuf(0),
+      _fftWorkBuf(0),
+      _operationalBuffer(nullptr),
+      _fftSpecC(nullptr),
+      _fftSpecBufC(0),
+      _fftWorkBufC(0)
+    {
+      ippInit();
+    }
+
+    IntelIppFFT(const IntelIppFFT&) = delete;
+    IntelIppFFT& operator=(const IntelIppFFT&) = delete;
 
     /**
      * @brief Calculates the necessary size of the real/imaginary complex arrays
      * @param size The size of the real data
      * @return The size of the real/imaginary complex arrays
      */
-    static size_t ComplexSize(size_t size);
+    static size_t ComplexSize(size_t size)
+    {
+      return (size / 2) + 1;
+    }
+
+    ~IntelIppFFT()
+    {
+      init(0);
+    }
+
+    void init(size_t size)
+    {
+      assert(detail::IsPowerOf2(size));
+      if (_fftSpec)
+      {
+        if (_fftWorkBuf) ippFree(_fftWorkBuf);
+        if (_fftSpecBuf) ippFree(_fftSpecBuf);
+        if (_fftWorkBufC) ippFree(_fftWorkBufC);
+        if (_fftSpecBufC) ippFree(_fftSpecBufC);
+        ippFree(_operationalBuffer);
+
+        _size = 0;
+        _operationalBufferSize = 0;
+        _powerOf2 = 0;
+        _fftSpec = 0;
+        _fftSpecC = 0;
+      }
+
+      if (size > 0)
+      {
+        _size = size;
+        _operationalBufferSize = _size + 2;
+        _powerOf2 = (int)(log((double)_size)/log(2.0));
+
+        // Query to get buffer sizes
+        int sizeFFTSpec,
+          sizeFFTInitBuf,
+          sizeFFTWorkBuf;
+        ippsFFTGetSize_R_32f(
+          _powerOf2,
+          IPP_FFT_NODIV_BY_ANY,
+          ippAlgHintAccurate,
+          &sizeFFTSpec,
+          &sizeFFTInitBuf,
+          &sizeFFTWorkBuf
+        );
+
+        Ipp8u* fftInitBuf;
+
+        // init buffers
+        _fftSpecBuf = ippsMalloc_8u(sizeFFTSpec);
+        _fftWorkBuf = ippsMalloc_8u(sizeFFTWorkBuf);
+        fftInitBuf = ippsMalloc_8u(sizeFFTInitBuf);
+
+        // Initialize FFT
+        ippsFFTInit_R_32f(
+          &_fftSpec,
+          _powerOf2,
+          IPP_FFT_NODIV_BY_ANY, 
+          ippAlgHintAccurate,
+          _fftSpecBuf,
+          fftInitBuf
+        );
+        if (fftInitBuf) ippFree(fftInitBuf);
+
+        // init operational buffer
+        _operationalBuffer = ippsMalloc_32f(
+          _operationalBufferSize
+        );
+
+        // Complex transform of the same size
+        ippsFFTGetSize_C_32f(
+          _powerOf2,
+          IPP_FFT_DIV_INV_BY_N,
+          ippAlgHintAccurate,
+          &sizeFFTSpec,
+          &sizeFFTInitBuf,
+          &sizeFFTWorkBuf
+        );
+
+        _fftSpecBufC = ippsMalloc_8u(sizeFFTSpec);
+        _fftWorkBufC = ippsMalloc_8u(sizeFFTWorkBuf);
+        fftInitBuf = ippsMalloc_8u(sizeFFTInitBuf);
+
+        ippsFFTInit_C_32f(
+          &_fftSpecC,
+          _powerOf2,
+          IPP_FFT_DIV_INV_BY_N,
+          ippAlgHintAccurate,
+          _fftSpecBufC,
+          fftInitBuf
+        );
+        if (fftInitBuf) ippFree(fftInitBuf);
+      }
+    }
+
+    void fft(const float* data, float* re, float* im)
+    {
+      size_t complexNumbersCount = _operationalBufferSize / 2;
+      ippsFFTFwd_RToCCS_32f(
+        data,
+        _operationalBuffer,
+        _fftSpec,
+        _fftWorkBuf
+      );
+
+      // no need to scale
+
+      size_t complexCounter = 0;
+      for (int i = 0; i < complexNumbersCount; ++i)
+      {
+        re[i] = _operationalBuffer[complexCounter++];
+        im[i] = _operationalBuffer[complexCounter++];
+      }
+    }
+
+    void ifft(float* data, const float* re, const float* im)
+    {
+      size_t complexNumbersCount = _operationalBufferSize / 2;
+
+      size_t complexCounter = 0;
+      for (int i = 0; i < complexNumbersCount; ++i)
+      {
+        _operationalBuffer[complexCounter++] = re[i];
+        _operationalBuffer[complexCounter++] = im[i];
+      }
+
+      ippsFFTInv_CCSToR_32f(
+        _operationalBuffer,
+        data,
+        _fftSpec,
+        _fftWorkBuf
+      );
+
+      // scaling
+      const float factor = 1.0f / static_cast<float>(_size);
+      ippsMulC_32f_I(factor, data, _size);
+    }
+
+    void cfft(const float* dataRe, const float* dataIm, float* re, float* im)
+    {
+      ippsFFTFwd_CToC_32f(dataRe, dataIm, re, im, _fftSpecC, _fftWorkBufC);
+    }
+
+    void cifft(float* dataRe, float* dataIm, const float* re, const float* im)
+    {
+      // scaling is done by IPP_FFT_DIV_INV_BY_N
+      ippsFFTInv_CToC_32f(re, im, dataRe, dataIm, _fftSpecC, _fftWorkBufC);
+    }
 
   private:
-    std::unique_ptr<detail::AudioFFTImpl> _impl;
+    size_t _size;
+    size_t _operationalBufferSize;
+    size_t _powerOf2;
+    IppsFFTSpec_R_32f* _fftSpec;
+    Ipp8u* _fftSpecBuf;
+    Ipp8u* _fftWorkBuf;
+    Ipp32f* _operationalBuffer;
+    IppsFFTSpec_C_32f* _fftSpecC;
+    Ipp8u* _fftSpecBufC;
+    Ipp8u* _fftWorkBufC;
   };
 
 
+#endif // AUDIOFFT_INTEL_IPP_USED
+
+
+  // ================================================================
+
+
+#ifdef AUDIOFFT_APPLE_ACCELERATE_USED
+
+
+  /**
+   * @internal
+   * @class AppleAccelerateFFT
+   * @brief FFT implementation using the Apple Accelerate framework internally
+   */
+  class AppleAccelerateFFT final
+  {
+  public:
+    AppleAccelerateFFT() :
+      _size(0),
+      _powerOf2(0),
+      _fftSetup(0),
+      _re(),
+      _im()
+    {
+    }
+
+    AppleAccelerateFFT(const AppleAccelerateFFT&) = delete;
+    AppleAccelerateFFT& operator=(const AppleAccelerateFFT&) = delete;
+
+    /**
+     * @brief Calculates the necessary size of the real/imaginary complex arrays
+     * @param size The size of the real data
+     * @return The size of the real/imaginary complex arrays
+     */
+    static size_t ComplexSize(size_t size)
+    {
+      return (size / 2) + 1;
+    }
+
+    ~AppleAccelerateFFT()
+    {
+      init(0);
+    }
+
+    void init(size_t size)
+    {
+      assert(detail::IsPowerOf2(size));
+      if (_fftSetup)
+      {
+        vDSP_destroy_fftsetup(_fftSetup);
+        _size = 0;
+        _powerOf2 = 0;
+        _fftSetup = 0;
+        _re.clear();
+        _im.clear();
+      }
+
+      if (size > 0)
+      {
+        _size = size;
+        _powerOf2 = 0;
+        while ((1 << _powerOf2) < _size)
+        {
+          ++_powerOf2;
+        }
+        _fftSetup = vDSP_create_fftsetup(_powerOf2, FFT_RADIX2);
+        _re.resize(_size / 2);
+        _im.resize(_size / 2);
+      }
+    }
+
+    void fft(const float* data, float* re, float* im)
+    {
+      const size_t size2 = _size / 2;
+      DSPSplitComplex splitComplex;
+      splitComplex.realp = re;
+      splitComplex.imagp = im;
+      vDSP_ctoz(reinterpret_cast<const COMPLEX*>(data), 2, &splitComplex, 1, size2);
+      vDSP_fft_zrip(_fftSetup, &splitComplex, 1, _powerOf2, FFT_FORWARD);
+      const float factor = 0.5f;
+      vDSP_vsmul(re, 1, &factor, re, 1, size2);
+      vDSP_vsmul(im, 1, &factor, im, 1, size2);
+      re[size2] = im[0];
+      im[0] = 0.0f;
+      im[size2] = 0.0f;
+    }
+
+    void ifft(float* data, const float* re, const float* im)
+    {
+      const size_t size2 = _size / 2;
+      ::memcpy(_re.data(), re, size2 * sizeof(float));
+      ::memcpy(_im.data(), im, size2 * sizeof(float));
+      _im[0] = re[size2];
+      DSPSplitComplex splitComplex;
+      splitComplex.realp = _re.data();
+      splitComplex.imagp = _im.data();
+      vDSP_fft_zrip(_fftSetup, &splitComplex, 1, _powerOf2, FFT_INVERSE);
+      vDSP_ztoc(&splitComplex, 1, reinterpret_cast<COMPLEX*>(data), 2, size2);
+      const float factor = 1.0f / static_cast<float>(_size);
+      vDSP_vsmul(data, 1, &factor, data, 1, _size);
+    }
+
+    void cfft(const float* dataRe, const float* dataIm, float* re, float* im)
+    {
+      DSPSplitComplex in;
+      in.realp = const_cast<float*>(dataRe);
+      in.imagp = const_cast<float*>(dataIm);
+      DSPSplitComplex out;
+      out.realp = re;
+      out.imagp = im;
+      vDSP_fft_zop(_fftSetup, &in, 1, &out, 1, _powerOf2, FFT_FORWARD);
+    }
+
+    void cifft(float* dataRe, float* dataIm, const float* re, const float* im)
+    {
+      DSPSplitComplex in;
+      in.realp = const_cast<float*>(re);
+      in.imagp = const_cast<float*>(im);
+      DSPSplitComplex out;
+      out.realp = dataRe;
+      out.imagp = dataIm;
+      vDSP_fft_zop(_fftSetup, &in, 1, &out, 1, _powerOf2, FFT_INVERSE);
+      const float factor = 1.0f / static_cast<float>(_size);
+      vDSP_vsmul(dataRe, 1, &factor, dataRe, 1, _size);
+      vDSP_vsmul(dataIm, 1, &factor, dataIm, 1, _size);
+    }
+
+  private:
+    size_t _size;
+    size_t _powerOf2;
+    FFTSetup _fftSetup;
+    std::vector<float> _re;
+    std::vector<float> _im;
+  };
+
+
+#endif // AUDIOFFT_APPLE_ACCELERATE_USED
+
+
+  // ================================================================
+
+
+#ifdef AUDIOFFT_FFTW3_USED
+
+
+  /**
+   * @internal
+   * @class FFTW3FFT
+   * @brief FFT implementation using FFTW3 internally (see fftw.org)
+   */
+  class FFTW3FFT final
+  {
+  public:
+    FFTW3FFT() :
+      _size(0),
+      _complexSize(0),
+      _planForward(0),
+      _planBackward(0),
+      _planComplex(0),
+      _planComplexInverse(0),
+      _data(0),
+      _re(0),
+      _im(0),
+      _cRe(0),
+      _cIm(0)
+    {
+    }
+
+    FFTW3FFT(const FFTW3FFT&) = delete;
+    FFTW3FFT& operator=(const FFTW3FFT&) = delete;
+
+    /**
+     * @brief Calculates the necessary size of the real/imaginary complex arrays
+     * @param size The size of the real data
+     * @return The size of the real/imaginary complex arrays
+     */
+    static size_t ComplexSize(size_t size)
+    {
+      return (size / 2) + 1;
+    }
+
+    ~FFTW3FFT()
+    {
+      init(0);
+    }
+
+    void init(size_t size)
+    {
+      assert(detail::IsPowerOf2(size));
+      if (_size != size)
+      {
+        if (_size > 0)
+        {
+          fftwf_destroy_plan(_planForward);
+          fftwf_destroy_plan(_planBackward);
+          fftwf_destroy_plan(_planComplex);
+          fftwf_destroy_plan(_planComplexInverse);
+          _planForward = 0;
+          _planBackward = 0;
+          _planComplex = 0;
+          _planComplexInverse = 0;
+          _size = 0;
+          _complexSize = 0;
+
+          if (_data)
+          {
+            fftwf_free(_data);
+            _data = 0;
+          }
+
+          if (_re)
+          {
+            fftwf_free(_re);
+            _re = 0;
+          }
+
+          if (_im)
+          {
+            fftwf_free(_im);
+            _im = 0;
+          }
+
+          if (_cRe)
+          {
+            fftwf_free(_cRe);
+            _cRe = 0;
+          }
+
+          if (_cIm)
+          {
+            fftwf_free(_cIm);
+            _cIm = 0;
+          }
+        }
+
+        if (size > 0)
+        {
+          _size = size;
+          _complexSize = ComplexSize(_size);
+          const size_t complexSize = ComplexSize(_size);
+          _data = reinterpret_cast<float*>(fftwf_malloc(_size * sizeof(float)));
+          _re = reinterpret_cast<float*>(fftwf_malloc(complexSize * sizeof(float)));
+          _im = reinterpret_cast<float*>(fftwf_malloc(complexSize * sizeof(float)));
+
+          fftw_iodim dim;
+          dim.n = static_cast<int>(size);
+          dim.is = 1;
+          dim.os = 1;
+          _planForward = fftwf_plan_guru_split_dft_r2c(1, &dim, 0, 0, _data, _re, _im, FFTW_MEASURE);
+          _planBackward = fftwf_plan_guru_split_dft_c2r(1, &dim, 0, 0, _re, _im, _data, FFTW_MEASURE);
+
+          // In-place complex plans, the inverse is the forward one with re and im swapped. It gets a plan
+          // of its own, new-array execution must keep the im - re distance the plan was made with
+          _cRe = reinterpret_cast<float*>(fftwf_malloc(_size * sizeof(float)));
+          _cIm = reinterpret_cast<float*>(fftwf_malloc(_size * sizeof(float)));
+          _planComplex = fftwf_plan_guru_split_dft(1, &dim, 0, 0, _cRe, _cIm, _cRe, _cIm, FFTW_MEASURE);
+          _planComplexInverse = fftwf_plan_guru_split_dft(1, &dim, 0, 0, _cIm, _cRe, _cIm, _cRe, FFTW_MEASURE);
+        }
+      }
+    }
+
+    void fft(const float* data, float* re, float* im)
+    {
+      ::memcpy(_data, data, _size * sizeof(float));
+      fftwf_execute_split_dft_r2c(_planForward, _data, _re, _im);
+      ::memcpy(re, _re, _complexSize * sizeof(float));
+      ::memcpy(im, _im, _complexSize * sizeof(float));
+    }
+
+    void ifft(float* data, const float* re, const float* im)
+    {
+      ::memcpy(_re, re, _complexSize * sizeof(float));
+      ::memcpy(_im, im, _complexSize * sizeof(float));
+      fftwf_execute_split_dft_c2r(_planBackward, _re, _im, _data);
+      detail::ScaleBuffer(data, _data, 1.0f / static_cast<float>(_size), _size);
+    }
+
+    void cfft(const float* dataRe, const float* dataIm, float* re, float* im)
+    {
+      ::memcpy(_cRe, dataRe, _size * sizeof(float));
+      ::memcpy(_cIm, dataIm, _size * sizeof(float));
+      fftwf_execute_split_dft(_planComplex, _cRe, _cIm, _cRe, _cIm);
+      ::memcpy(re, _cRe, _size * sizeof(float));
+      ::memcpy(im, _cIm, _size * sizeof(float));
+    }
+
+    void cifft(float* dataRe, float* dataIm, const float* re, const float* im)
+    {
+      ::memcpy(_cRe, re, _size * sizeof(float));
+      ::memcpy(_cIm, im, _size * sizeof(float));
+      fftwf_execute(_planComplexInverse);
+      detail::ScaleBuffer(dataRe, _cRe, 1.0f / static_cast<float>(_size), _size);
+      detail::ScaleBuffer(dataIm, _cIm, 1.0f / static_cast<float>(_size), _size);
+    }
+
+  private:
+    size_t _size;
+    size_t _complexSize;
+    fftwf_plan _planForward;
+    fftwf_plan _planBackward;
+    fftwf_plan _planComplex;
+    fftwf_plan _planComplexInverse;
+    float* _data;
+    float* _re;
+    float* _im;
+    float* _cRe;
+    float* _cIm;
+  };
+
+
+#endif // AUDIOFFT_FFTW3_USED
+
+  // =============================================================
+
+
+  // Instantiated once in AudioFFT.cpp
+  extern template class OouraFFT<float>;
+  extern template class OouraFFT<double>;
+
+
+  /**
+   * @class AudioFFT
+   * @brief Performs 1D FFTs, the backend selected at compile time
+   *
+   * All backends have the same interface: init(), fft(), ifft(), cfft(), cifft() and
+   * ComplexSize(). There is no virtual dispatch or heap indirection, the object can be
+   * embedded by value and its calls can be inlined.
+   */
+#if defined(AUDIOFFT_INTEL_IPP_USED)
+  typedef IntelIppFFT AudioFFT;
+#elif defined(AUDIOFFT_APPLE_ACCELERATE_USED)
+  typedef AppleAccelerateFFT AudioFFT;
+#elif defined(AUDIOFFT_FFTW3_USED)
+  typedef FFTW3FFT AudioFFT;
+#elif defined(AUDIOFFT_OOURA_USED) && defined(AUDIOFFT_OOURA_DOUBLE)
+  typedef OouraFFT<double> AudioFFT;
+#elif defined(AUDIOFFT_OOURA_USED)
+  typedef OouraFFT<float> AudioFFT;
+#else
+  typedef SimdFFT AudioFFT;
+#endif
+
+
   /**
    * @deprecated
    * @brief Let's keep an AudioFFTBase type around for now because it has been here already in the 1st version in order to avoid breaking existing code.
@@ -19,13 +19,16 @@
 // WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 // ==================================================================================
 
+#include <algorithm>
 #include <vector>
 
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
 
-#include "../AudioFFT.h"
+// Built as a single translation unit (no need to link AudioFFT.cpp), so the
+// internal implementations can be compared against each other
+#include "../AudioFFT.cpp"
 
 
 #define TEST_CORRECTNESS
@@ -171,6 +174,219 @@ static void TestCorrectness()
 }
 
 
+static void TestComplexCorrectness(size_t inputSize)
+{
+  bool success = true;
+
+  std::vector<float> inputRe(inputSize);
+  std::vector<float> inputIm(inputSize);
+  for (size_t i=0; i<inputSize; ++i)
+  {
+    inputRe[i] = static_cast<float>(i+1);
+    inputIm[i] = static_cast<float>(inputSize-i) * 0.5f;
+  }
+
+  // Naive DFT in double as reference
+  const double pi = 3.14159265358979323846;
+  std::vector<double> refRe(inputSize);
+  std::vector<double> refIm(inputSize);
+  for (size_t k=0; k<inputSize; ++k)
+  {
+    double sumRe = 0.0;
+    double sumIm = 0.0;
+    for (size_t n=0; n<inputSize; ++n)
+    {
+      const double phase = -2.0 * pi * static_cast<double>((k * n) % inputSize) / static_cast<double>(inputSize);
+      sumRe += inputRe[n] * ::cos(phase) - inputIm[n] * ::sin(phase);
+      sumIm += inputRe[n] * ::sin(phase) + inputIm[n] * ::cos(phase);
+    }
+    refRe[k] = sumRe;
+    refIm[k] = sumIm;
+  }
+
+  audiofft::AudioFFT fft;
+  fft.init(inputSize);
+
+  std::vector<float> re(inputSize);
+  std::vector<float> im(inputSize);
+  fft.cfft(&inputRe[0], &inputIm[0], &re[0], &im[0]);
+  const double tolerance = 1e-5 * static_cast<double>(inputSize * inputSize);
+  success &= (CheckBuffers(inputSize, re, refRe, tolerance) == true);
+  success &= (CheckBuffers(inputSize, im, refIm, tolerance) == true);
+
+  std::vector<float> backwardRe(inputSize, -10000.0f);
+  std::vector<float> backwardIm(inputSize, -10000.0f);
+  fft.cifft(&backwardRe[0], &backwardIm[0], &re[0], &im[0]);
+  success &= (CheckBuffers(inputSize, backwardRe, inputRe) == true);
+  success &= (CheckBuffers(inputSize, backwardIm, inputIm) == true);
+
+  printf("Complex correctness (input size %d) => %s\n", static_cast<int>(inputSize), success ? "[OK]" : "[FAILED]");
+}
+
+
+static void TestComplexCorrectness()
+{
+  for (size_t size=2; size<=1024; size*=2)
+  {
+    TestComplexCorrectness(size);
+  }
+}
+
+
+template<typename TA, typename TB>
+static double MaxDiff(size_t size, const TA& a, const TB& b)
+{
+  double maxDiff = 0.0;
+  for (size_t i=0; i<size; ++i)
+  {
+    maxDiff = std::max(maxDiff, ::fabs(static_cast<double>(a[i]) - static_cast<double>(b[i])));
+  }
+  return maxDiff;
+}
+
+
+template<typename T>
+static double MaxAbs(const T& a)
+{
+  return MaxDiff(a.size(), a, std::vector<double>(a.size(), 0.0));
+}
+
+
+template<typename Impl>
+static void TestAccuracy(const char* name, size_t inputSize)
+{
+  bool success = true;
+
+  std::vector<float> inputRe(inputSize);
+  std::vector<float> inputIm(inputSize);
+  unsigned seed = 12345;
+  for (size_t i=0; i<inputSize; ++i)
+  {
+    seed = seed * 1664525u + 1013904223u;
+    inputRe[i] = static_cast<float>(seed >> 8) / static_cast<float>(1u << 23) - 1.0f;
+    seed = seed * 1664525u + 1013904223u;
+    inputIm[i] = static_cast<float>(seed >> 8) / static_cast<float>(1u << 23) - 1.0f;
+  }
+
+  Impl fftFloat;
+  audiofft::OouraFFT<double> fftDouble;
+  fftFloat.init(inputSize);
+  fftDouble.init(inputSize);
+
+  // Spectra are compared relative to their peak, time signals are in [-1, 1)
+  const double spectrumTolerance = 1e-6 * std::log2(static_cast<double>(inputSize) * 2.0);
+  const double signalTolerance = 1e-5;
+
+  const size_t complexSize = audiofft::AudioFFT::ComplexSize(inputSize);
+  std::vector<float> reFloat(complexSize);
+  std::vector<float> imFloat(complexSize);
+  std::vector<float> reDouble(complexSize);
+  std::vector<float> imDouble(complexSize);
+  fftFloat.fft(inputRe.data(), reFloat.data(), imFloat.data());
+  fftDouble.fft(inputRe.data(), reDouble.data(), imDouble.data());
+  const double peak = std::max(MaxAbs(reDouble), MaxAbs(imDouble));
+  success &= MaxDiff(complexSize, reFloat, reDouble) <= spectrumTolerance * peak;
+  success &= MaxDiff(complexSize, imFloat, imDouble) <= spectrumTolerance * peak;
+
+  std::vector<float> backwardFloat(inputSize);
+  std::vector<float> backwardDouble(inputSize);
+  fftFloat.ifft(backwardFloat.data(), reDouble.data(), imDouble.data());
+  fftDouble.ifft(backwardDouble.data(), reDouble.data(), imDouble.data());
+  success &= MaxDiff(inputSize, backwardFloat, backwardDouble) <= signalTolerance;
+  success &= MaxDiff(inputSize, backwardFloat, inputRe) <= signalTolerance;
+
+  std::vector<float> cReFloat(inputSize);
+  std::vector<float> cImFloat(inputSize);
+  std::vector<float> cReDouble(inputSize);
+  std::vector<float> cImDouble(inputSize);
+  fftFloat.cfft(inputRe.data(), inputIm.data(), cReFloat.data(), cImFloat.data());
+  fftDouble.cfft(inputRe.data(), inputIm.data(), cReDouble.data(), cImDouble.data());
+  const double cPeak = std::max(MaxAbs(cReDouble), MaxAbs(cImDouble));
+  success &= MaxDiff(inputSize, cReFloat, cReDouble) <= spectrumTolerance * cPeak;
+  success &= MaxDiff(inputSize, cImFloat, cImDouble) <= spectrumTolerance * cPeak;
+
+  std::vector<float> cBackwardRe(inputSize);
+  std::vector<float> cBackwardIm(inputSize);
+  fftFloat.cifft(cBackwardRe.data(), cBackwardIm.data(), cReDouble.data(), cImDouble.data());
+  success &= MaxDiff(inputSize, cBackwardRe, inputRe) <= signalTolerance;
+  success &= MaxDiff(inputSize, cBackwardIm, inputIm) <= signalTolerance;
+
+  printf("%s vs Ooura double (input size %d) => %s\n", name, static_cast<int>(inputSize), success ? "[OK]" : "[FAILED]");
+}
+
+
+static void TestAccuracy()
+{
+  for (size_t size=2; size<=16384; size*=2)
+  {
+    TestAccuracy<audiofft::OouraFFT<float>>("Ooura float", size);
+  }
+  for (size_t size=2; size<=16384; size*=2)
+  {
+    TestAccuracy<audiofft::SimdFFT>("SimdFFT", size);
+  }
+}
+
+
+template<typename Impl>
+static bool SameTransform(Impl& fft, size_t inputSize, const std::vector<float>& input)
+{
+  // a transform of its own builds nothing new, it is compared bit for bit
+  Impl lone;
+  lone.init(inputSize);
+  const size_t complexSize = audiofft::AudioFFT::ComplexSize(inputSize);
+  std::vector<float> re(complexSize), im(complexSize), loneRe(complexSize), loneIm(complexSize);
+  fft.fft(input.data(), re.data(), im.data());
+  lone.fft(input.data(), loneRe.data(), loneIm.data());
+  std::vector<float> cRe(inputSize), cIm(inputSize), loneCRe(inputSize), loneCIm(inputSize);
+  fft.cfft(input.data(), input.data(), cRe.data(), cIm.data());
+  lone.cfft(input.data(), input.data(), loneCRe.data(), loneCIm.data());
+  return re == loneRe && im == loneIm && cRe == loneCRe && cIm == loneCIm;
+}
+
+
+template<typename Impl>
+static void TestSharedPlans(const char* name, size_t inputSize)
+{
+  bool success = true;
+
+  std::vector<float> input(inputSize);
+  for (size_t i=0; i<inputSize; ++i)
+  {
+    input[i] = static_cast<float>((i * 7) % 13) - 6.0f;
+  }
+
+  // every one of them shares the tables of inputSize
+  std::vector<Impl> ffts(3);
+  for (auto& fft : ffts)
+  {
+    fft.init(inputSize);
+  }
+  for (auto& fft : ffts)
+  {
+    success &= SameTransform(fft, inputSize, input);
+  }
+
+  // a transform that moves to another size does not change the others
+  ffts[0].init(inputSize * 2);
+  success &= SameTransform(ffts[1], inputSize, input);
+  ffts[0].init(inputSize);
+  success &= SameTransform(ffts[0], inputSize, input);
+
+  printf("%s shared plans (input size %d) => %s\n", name, static_cast<int>(inputSize), success ? "[OK]" : "[FAILED]");
+}
+
+
+static void TestSharedPlans()
+{
+  for (size_t size=2; size<=4096; size*=8)
+  {
+    TestSharedPlans<audiofft::OouraFFT<float>>("Ooura float", size);
+    TestSharedPlans<audiofft::SimdFFT>("SimdFFT", size);
+  }
+}
+
+
 static void TestPerformance(const size_t inputSize)
 {
   const size_t overallSize = size_t(512) * size_t(1024) * size_t(1024);
@@ -247,6 +463,9 @@ int main()
 { 
 #ifdef TEST_CORRECTNESS
   TestCorrectness();
+  TestComplexCorrectness();
+  TestAccuracy();
+  TestSharedPlans();
 #endif
   
 #ifdef TEST_PERFORMANCE
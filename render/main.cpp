@@ -0,0 +1,486 @@
+#include <juce_audio_formats/juce_audio_formats.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "dsp/multires_phaser.hpp"
+#include "dsp/phaser.hpp"
+#include "plugin_state.hpp"
+
+namespace {
+
+constexpr size_t kNumLayers = phaser::SpectralPhaser::kNumLayers;
+// host block size of the render, Update() runs once per block like in processBlock
+constexpr int kBlockSize = 512;
+// EmptyAudioProcessor::kParameterValueTreeIdentify
+constexpr auto kParameterTree = "PARAMETERS";
+constexpr auto kPluginStateTree = "PLUGIN_STATE";
+// AudioProcessor::copyXmlToBinary() writes this, the size and then the xml text
+constexpr juce::uint32 kBinaryXmlMagic = 0x21324356;
+
+/**
+ * @brief the plugin parameters, with the same defaults as the parameter layout
+ */
+struct Settings {
+    Settings() {
+        for (size_t i = 0; i < kNumLayers; ++i) {
+            auto& l = layers[i];
+            l.enable = i == 0;
+            l.pitch = 100.0f;
+            l.morph = 0.5f;
+            l.phase = 0.5f;
+            l.drywet = 1.0f;
+            l.barber_freq = 0.0f;
+        }
+    }
+
+    std::array<phaser::SpectralPhaserLayer, kNumLayers> layers;
+    bool phasy{};
+    phaser::PhasyType phasy_type{};
+    float phasy_smooth{};
+    bool multires{};
+    phaser::SpectralPhaser::Mode mode;
+    phaser::SpectralPhaser::Sparse sparse;
+};
+
+// same mapping as the parameter listeners of EmptyAudioProcessor
+void ApplyParameter(Settings& s, juce::String const& id, float v) {
+    if (id == "phasy") {
+        s.phasy = v > 0.5f;
+        return;
+    }
+    if (id == "phasy_type") {
+        int const type = juce::roundToInt(v);
+        s.phasy_type = type == 0 ? phaser::PhasyType::kPhase : phaser::PhasyType::kGain;
+        s.phasy_smooth = type == 2 ? 0.2f : 0.0f;
+        return;
+    }
+    if (id == "multires") {
+        s.multires = v > 0.5f;
+        return;
+    }
+    if (id == "fft_auto") {
+        s.mode.scale_with_fs = v > 0.5f;
+        return;
+    }
+    if (id == "fft_size") {
+        s.mode.fft_size = phaser::SpectralPhaser::kMinFftSize << juce::roundToInt(v);
+        return;
+    }
+    if (id == "overlap") {
+        s.mode.overlap = size_t{2} << juce::roundToInt(v);
+        return;
+    }
+    if (id == "window") {
+        s.mode.window = static_cast<qwqdsp_window::Shape>(juce::roundToInt(v));
+        return;
+    }
+    if (id == "sparse") {
+        s.sparse.enable = v > 0.5f;
+        return;
+    }
+    if (id == "sparse_threshold") {
+        s.sparse.threshold_db = v;
+        return;
+    }
+    if (id == "sparse_low") {
+        s.sparse.min_freq = v;
+        return;
+    }
+    if (id == "sparse_high") {
+        // the top of the range is no limit
+        s.sparse.max_freq = v >= 24000.0f ? std::numeric_limits<float>::infinity() : v;
+        return;
+    }
+
+    // per layer ids end with the layer index
+    auto const name = id.trimCharactersAtEnd("0123456789");
+    if (name.length() == id.length()) return;
+    auto const idx = static_cast<size_t>(id.substring(name.length()).getIntValue());
+    if (idx >= kNumLayers) return;
+    auto& l = s.layers[idx];
+    if (name == "enable") l.enable = v > 0.5f;
+    else if (name == "pitch") l.pitch = v;
+    else if (name == "morph") l.morph = v;
+    else if (name == "phase") l.phase = v;
+    else if (name == "drywet") l.drywet = v;
+    // there is no tempo offline, a synced lfo runs at its free rate
+    else if (name == "freq") l.barber_freq = v;
+}
+
+// the binary state only keeps hashes of the ids
+void ApplyHashedParameter(Settings& s, uint32_t id_hash, float v) {
+    std::vector<juce::String> ids{"phasy",  "phasy_type", "multires",         "fft_auto",   "fft_size",   "overlap",
+                                  "window", "sparse",     "sparse_threshold", "sparse_low", "sparse_high"};
+    for (size_t i = 0; i < kNumLayers; ++i) {
+        for (auto const* name : {"enable", "pitch", "morph", "phase", "drywet", "freq"}) {
+            ids.push_back(name + juce::String{i});
+        }
+    }
+    for (auto const& id : ids) {
+        if (plugin_state::Hash(id.toStdString()) == id_hash) {
+            ApplyParameter(s, id, v);
+            return;
+        }
+    }
+}
+
+std::unique_ptr<juce::XmlElement> ReadStateXml(juce::MemoryBlock const& data) {
+    // binary xml state, as saved by getStateInformation() before plugin_state
+    if (data.getSize() > 8 && juce::ByteOrder::littleEndianInt(data.getData()) == kBinaryXmlMagic) {
+        auto const* bytes = static_cast<char const*>(data.getData());
+        auto const size = std::min(static_cast<size_t>(juce::ByteOrder::littleEndianInt(bytes + 4)),
+                                   data.getSize() - 8);
+        return juce::parseXML(juce::String::fromUTF8(bytes + 8, static_cast<int>(size)));
+    }
+    return juce::parseXML(data.toString());
+}
+
+/**
+ * @param file plugin state (binary or xml) or a preset, all but the binary state hold the parameter tree
+ */
+bool LoadSettings(juce::File const& file, Settings& s, juce::String& error) {
+    juce::MemoryBlock data;
+    if (!file.loadFileAsData(data)) {
+        error = "can not read " + file.getFullPathName();
+        return false;
+    }
+
+    std::vector<plugin_state::Entry> entries;
+    if (plugin_state::Decode(data.getData(), data.getSize(), entries)) {
+        for (auto const& e : entries) {
+            ApplyHashedParameter(s, e.id_hash, e.value);
+        }
+        return true;
+    }
+
+    auto xml = ReadStateXml(data);
+    if (xml == nullptr) {
+        error = "can not parse " + file.getFullPathName();
+        return false;
+    }
+
+    auto tree = juce::ValueTree::fromXml(*xml);
+    if (tree.hasType(kPluginStateTree)) {
+        tree = tree.getChildWithName(kParameterTree);
+    }
+    if (!tree.hasType(kParameterTree)) {
+        error = file.getFullPathName() + " holds no " + kParameterTree + " tree";
+        return false;
+    }
+
+    for (auto const& param : tree) {
+        if (param.hasProperty("id") && param.hasProperty("value")) {
+            ApplyParameter(s, param["id"].toString(), static_cast<float>(param["value"]));
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief one dsp instance for every channel of a file, only the engine the settings select is allocated
+ */
+class Engine {
+public:
+    void Prepare(Settings const& s, float fs, size_t num_channels) {
+        multires_active_ = s.multires;
+        if (multires_active_) {
+            if (multires_ == nullptr) multires_ = std::make_unique<phaser::MultiResolutionPhaser>();
+            ApplyLayers(*multires_, s);
+            multires_->Init(fs, num_channels);
+        }
+        else {
+            if (single_ == nullptr) single_ = std::make_unique<phaser::SpectralPhaser>();
+            ApplyLayers(*single_, s);
+            single_->SetMode(s.mode);
+            single_->SetSparse(s.sparse);
+            single_->Init(fs, num_channels);
+        }
+    }
+
+    size_t GetLatency() const noexcept {
+        return multires_active_ ? multires_->GetLatency() : single_->GetLatency();
+    }
+
+    void Process(std::span<float* const> channels, size_t num_samples) noexcept {
+        if (multires_active_) {
+            multires_->Update();
+            multires_->Process(channels, num_samples);
+        }
+        else {
+            single_->Update();
+            single_->Process(channels, num_samples);
+        }
+    }
+private:
+    template <class Dsp>
+    static void ApplyLayers(Dsp& dsp, Settings const& s) {
+        dsp.phasy = s.phasy;
+        dsp.phasy_type = s.phasy_type;
+        dsp.phasy_smooth = s.phasy_smooth;
+        for (size_t i = 0; i < kNumLayers; ++i) {
+            auto const& src = s.layers[i];
+            auto& dst = dsp.GetLayer(i);
+            dst.enable = src.enable;
+            dst.pitch = src.pitch;
+            dst.morph = src.morph;
+            dst.phase = src.phase;
+            dst.drywet = src.drywet;
+            dst.barber_freq = src.barber_freq;
+            // every file starts from the same lfo phase
+            dst.SetLfoPhase(0.0f);
+        }
+    }
+
+    bool multires_active_{};
+    std::unique_ptr<phaser::SpectralPhaser> single_;
+    std::unique_ptr<phaser::MultiResolutionPhaser> multires_;
+};
+
+struct Job {
+    juce::File input;
+    juce::File output;
+};
+
+/**
+ * @brief owned by one worker thread, renders one file at a time
+ */
+class Renderer {
+public:
+    Renderer(Settings const& settings, int bits_per_sample)
+        : settings_(settings)
+        , bits_per_sample_(bits_per_sample) {
+        formats_.registerBasicFormats();
+    }
+
+    /**
+     * @return seconds of audio rendered, negative on error
+     */
+    double Render(Job const& job, juce::String& error) {
+        auto reader = CreateReader(job.input);
+        if (reader == nullptr) {
+            error = "can not read " + job.input.getFullPathName();
+            return -1.0;
+        }
+
+        auto const fs = reader->sampleRate;
+        int const num_channels = static_cast<int>(reader->numChannels);
+        if (num_channels == 0 || fs <= 0) {
+            error = job.input.getFullPathName() + " has no audio";
+            return -1.0;
+        }
+        if (static_cast<size_t>(num_channels) > phaser::SpectralPhaser::kMaxChannels) {
+            error = job.input.getFullPathName() + " has more than " +
+                    juce::String{phaser::SpectralPhaser::kMaxChannels} + " channels";
+            return -1.0;
+        }
+        juce::int64 const length = reader->lengthInSamples;
+        engine_.Prepare(settings_, static_cast<float>(fs), static_cast<size_t>(num_channels));
+        auto const latency = static_cast<juce::int64>(engine_.GetLatency());
+
+        job.output.getParentDirectory().createDirectory();
+        job.output.deleteFile();
+        std::unique_ptr<juce::OutputStream> stream = job.output.createOutputStream();
+        if (stream == nullptr) {
+            error = "can not write " + job.output.getFullPathName();
+            return -1.0;
+        }
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer{
+            wav.createWriterFor(stream.get(), fs, static_cast<unsigned int>(num_channels), bits_per_sample_, {}, 0)};
+        if (writer == nullptr) {
+            error = "no wav writer for " + job.output.getFullPathName();
+            return -1.0;
+        }
+        // the writer owns the stream now
+        stream.release();
+
+        // the input is followed by latency samples of silence, the first latency output samples are
+        // dropped, so the output lines up with the input and has the same length
+        buffer_.setSize(num_channels, kBlockSize, false, false, true);
+        juce::int64 read_pos = 0;
+        juce::int64 written = 0;
+        while (written < length) {
+            buffer_.clear();
+            // reading past the end gives zeros
+            reader->read(&buffer_, 0, kBlockSize, read_pos, true, true);
+            read_pos += kBlockSize;
+            engine_.Process({buffer_.getArrayOfWritePointers(), static_cast<size_t>(num_channels)},
+                            static_cast<size_t>(kBlockSize));
+
+            juce::int64 const block_begin = read_pos - kBlockSize - latency;
+            int const skip = static_cast<int>(std::clamp<juce::int64>(-block_begin, 0, kBlockSize));
+            int const count = static_cast<int>(std::min<juce::int64>(kBlockSize - skip, length - written));
+            if (count > 0) {
+                writer->writeFromAudioSampleBuffer(buffer_, skip, count);
+                written += count;
+            }
+        }
+        return static_cast<double>(length) / fs;
+    }
+private:
+    std::unique_ptr<juce::AudioFormatReader> CreateReader(juce::File const& file) {
+        // wav and aiff can be memory mapped, that saves a copy through the stream
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped;
+        if (file.hasFileExtension("wav")) {
+            mapped.reset(juce::WavAudioFormat{}.createMemoryMappedReader(file));
+        }
+        else if (file.hasFileExtension("aif;aiff")) {
+            mapped.reset(juce::AiffAudioFormat{}.createMemoryMappedReader(file));
+        }
+        if (mapped != nullptr && mapped->mapEntireFile()) {
+            return mapped;
+        }
+        return std::unique_ptr<juce::AudioFormatReader>{formats_.createReaderFor(file)};
+    }
+
+    Settings const& settings_;
+    int bits_per_sample_;
+    juce::AudioFormatManager formats_;
+    Engine engine_;
+    juce::AudioBuffer<float> buffer_;
+};
+
+struct Options {
+    juce::File state;
+    juce::File output_dir;
+    std::vector<juce::File> inputs;
+    int num_jobs{};
+    int bits_per_sample{24};
+};
+
+void PrintUsage() {
+    std::printf("usage: spectral_phaser_render --out dir [--state file] [--jobs n] [--bits 16|24|32] inputs...\n"
+                "  inputs   wav or aiff files, or directories searched recursively\n"
+                "  --out    rendered files are written here as wav, directory inputs keep their sub folders\n"
+                "  --state  plugin state or preset file, the parameter defaults are used without it\n"
+                "  --jobs   worker threads, default is one per core\n"
+                "  --bits   output bit depth, 32 is float, default 24\n");
+}
+
+bool ParseArgs(juce::StringArray const& args, Options& opt) {
+    auto const cwd = juce::File::getCurrentWorkingDirectory();
+    for (int i = 0; i < args.size(); ++i) {
+        bool const has_value = i + 1 < args.size();
+        if (args[i] == "--out" && has_value) {
+            opt.output_dir = cwd.getChildFile(args[++i]);
+        }
+        else if (args[i] == "--state" && has_value) {
+            opt.state = cwd.getChildFile(args[++i]);
+        }
+        else if (args[i] == "--jobs" && has_value) {
+            opt.num_jobs = args[++i].getIntValue();
+        }
+        else if (args[i] == "--bits" && has_value) {
+            opt.bits_per_sample = args[++i].getIntValue();
+        }
+        else if (args[i].startsWith("--")) {
+            return false;
+        }
+        else {
+            opt.inputs.push_back(cwd.getChildFile(args[i]));
+        }
+    }
+    return opt.output_dir != juce::File{} && !opt.inputs.empty();
+}
+
+std::vector<Job> CollectJobs(Options const& opt) {
+    constexpr auto kPatterns = "*.wav;*.aif;*.aiff";
+    std::vector<Job> jobs;
+    auto add = [&](juce::File const& input, juce::String const& relative) {
+        jobs.push_back({input, opt.output_dir.getChildFile(relative).withFileExtension("wav")});
+    };
+    for (auto const& input : opt.inputs) {
+        if (input.isDirectory()) {
+            for (auto const& entry :
+                 juce::RangedDirectoryIterator{input, true, kPatterns, juce::File::findFiles}) {
+                add(entry.getFile(), entry.getFile().getRelativePathFrom(input));
+            }
+        }
+        else {
+            add(input, input.getFileName());
+        }
+    }
+    return jobs;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i) {
+        args.add(juce::String::fromUTF8(argv[i]));
+    }
+
+    Options opt;
+    if (!ParseArgs(args, opt) || (opt.bits_per_sample != 16 && opt.bits_per_sample != 24 && opt.bits_per_sample != 32)) {
+        PrintUsage();
+        return 2;
+    }
+
+    Settings settings;
+    if (opt.state != juce::File{}) {
+        juce::String error;
+        if (!LoadSettings(opt.state, settings, error)) {
+            std::fprintf(stderr, "%s\n", error.toRawUTF8());
+            return 2;
+        }
+    }
+
+    auto const jobs = CollectJobs(opt);
+    if (jobs.empty()) {
+        std::fprintf(stderr, "no wav or aiff file found\n");
+        return 2;
+    }
+
+    size_t num_workers = opt.num_jobs > 0 ? static_cast<size_t>(opt.num_jobs)
+                                          : std::max(1u, std::thread::hardware_concurrency());
+    num_workers = std::min(num_workers, jobs.size());
+    std::printf("rendering %zu files on %zu workers\n", jobs.size(), num_workers);
+
+    std::atomic<size_t> next_job{0};
+    std::atomic<size_t> num_failed{0};
+    std::mutex result_lock;
+    double audio_seconds = 0;
+
+    auto const begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t w = 0; w < num_workers; ++w) {
+        workers.emplace_back([&] {
+            Renderer renderer{settings, opt.bits_per_sample};
+            for (size_t i = next_job++; i < jobs.size(); i = next_job++) {
+                juce::String error;
+                double const seconds = renderer.Render(jobs[i], error);
+
+                std::scoped_lock lock{result_lock};
+                if (seconds < 0) {
+                    ++num_failed;
+                    std::fprintf(stderr, "failed: %s\n", error.toRawUTF8());
+                }
+                else {
+                    audio_seconds += seconds;
+                    std::printf("%s\n", jobs[i].output.getFullPathName().toRawUTF8());
+                }
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    auto const end = std::chrono::steady_clock::now();
+
+    double const wall_seconds = std::max(std::chrono::duration<double>(end - begin).count(), 1e-9);
+    size_t const num_done = jobs.size() - num_failed;
+    std::printf("%zu files rendered, %zu failed, %.1f s\n", num_done, num_failed.load(), wall_seconds);
+    std::printf("%.1f files/min, %.1f s of audio, %.1fx realtime\n",
+                static_cast<double>(num_done) * 60.0 / wall_seconds, audio_seconds, audio_seconds / wall_seconds);
+    return num_failed == 0 ? 0 : 1;
+}
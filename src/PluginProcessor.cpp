@@ -2,6 +2,26 @@
 #include "PluginEditor.h"
 #include "global.hpp"
 
+namespace {
+// the ids of every layer as literals, building the layout does not concatenate strings
+struct LayerIds {
+    char const* phase;
+    char const* pitch;
+    char const* morph;
+    char const* freq;
+    char const* enable;
+    char const* drywet;
+};
+
+constexpr LayerIds kLayerIds[]{
+    {"phase0", "pitch0", "morph0", "freq0", "enable0", "drywet0"},
+    {"phase1", "pitch1", "morph1", "freq1", "enable1", "drywet1"},
+    {"phase2", "pitch2", "morph2", "freq2", "enable2", "drywet2"},
+    {"phase3", "pitch3", "morph3", "freq3", "enable3", "drywet3"},
+};
+static_assert(std::size(kLayerIds) == phaser::SpectralPhaser::kNumLayers);
+} // namespace
+
 //==============================================================================
 EmptyAudioProcessor::EmptyAudioProcessor()
     : AudioProcessor(BusesProperties()
@@ -15,67 +35,177 @@ EmptyAudioProcessor::EmptyAudioProcessor()
     juce::AudioProcessorValueTreeState::ParameterLayout layout;
 
     for (size_t i = 0; i < phaser::SpectralPhaser::kNumLayers; ++i) {
-        juce::String i_str{i};
+        auto const& ids = kLayerIds[i];
         {
-            auto p = std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{"phase" + i_str, 1}, "phase" + i_str,
+            auto p = std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{ids.phase, 1}, ids.phase,
                                                                  0.0f, 1.0f, 0.5f);
-            param_listener_.Add(p, [this, idx = i](float v) { dsp_.GetLayer(idx).phase = v; });
+            ListenShared(*p, [this, idx = i](float v) { shared_params_.Set(phaser::LayerParam::kPhase, idx, v); });
             layout.add(std::move(p));
         }
         {
-            auto p = std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{"pitch" + i_str, 1}, "pitch" + i_str,
+            auto p = std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{ids.pitch, 1}, ids.pitch,
                                                                  0.0f, 150.0f, 100.0f);
-            param_listener_.Add(p, [this, idx = i](float v) { dsp_.GetLayer(idx).pitch = v; });
+            ListenShared(*p, [this, idx = i](float v) { shared_params_.Set(phaser::LayerParam::kPitch, idx, v); });
             layout.add(std::move(p));
         }
         {
-            auto p = std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{"morph" + i_str, 1}, "morph" + i_str,
+            auto p = std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{ids.morph, 1}, ids.morph,
                                                                  0.0f, 1.0f, 0.5f);
-            param_listener_.Add(p, [this, idx = i](float v) { dsp_.GetLayer(idx).morph = v; });
+            ListenShared(*p, [this, idx = i](float v) { shared_params_.Set(phaser::LayerParam::kMorph, idx, v); });
             layout.add(std::move(p));
         }
         {
             // auto p = std::make_unique<juce::AudioParameterFloat>(
-            //     juce::ParameterID{"freq" + i_str, 1}, "freq" + i_str,
+            //     juce::ParameterID{ids.freq, 1}, ids.freq,
             //     juce::NormalisableRange<float>{-10.0f, 10.0f, 0.01f, 0.4f, true}, 0.0f);
             // param_listener_.Add(p, [this, idx = i](float v) { dsp_.GetLayer(idx).barber_freq = v; });
             // layout.add(std::move(p));
-            auto p = layer_lfo_[i].Build("freq" + i_str, -10.0f, 10.0f, 0.01f, 0.4f, true, "-1/64", "1/64");
+            auto p = layer_lfo_[i].Build(ids.freq, -10.0f, 10.0f, 0.01f, 0.4f, true, "-1/64", "1/64");
             layout.add(std::move(p.first), std::move(p.second));
         }
         {
-            auto p = std::make_unique<juce::AudioParameterBool>(juce::ParameterID{"enable" + i_str, 1},
-                                                                "enable" + i_str, i == 0);
-            param_listener_.Add(p, [this, idx = i](bool v) { dsp_.GetLayer(idx).enable = v; });
+            auto p = std::make_unique<juce::AudioParameterBool>(juce::ParameterID{ids.enable, 1}, ids.enable, i == 0);
+            ListenShared(*p, [this, idx = i](float v) {
+                shared_params_.Set(phaser::LayerParam::kEnable, idx, v > 0.5f ? 1.0f : 0.0f);
+            });
             layout.add(std::move(p));
         }
         {
             auto p =
-                std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{"drywet" + i_str, 1}, "drywet" + i_str,
+                std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{ids.drywet, 1}, ids.drywet,
                                                             juce::NormalisableRange<float>{0.0f, 1.0f, 0.01f}, 1.0f);
-            param_listener_.Add(p, [this, idx = i](float v) { dsp_.GetLayer(idx).drywet = v; });
+            ListenShared(*p, [this, idx = i](float v) { shared_params_.Set(phaser::LayerParam::kDrywet, idx, v); });
             layout.add(std::move(p));
         }
     }
     {
         auto p = std::make_unique<juce::AudioParameterBool>(juce::ParameterID{"phasy", 1}, "phasy", false);
-        param_listener_.Add(p, [this](bool v) { dsp_.phasy = v; });
+        ListenShared(*p, [this](float v) { shared_params_.SetPhasy(v > 0.5f); });
+        layout.add(std::move(p));
+    }
+    {
+        // smooth gain glides over 200ms
+        auto p = std::make_unique<juce::AudioParameterChoice>(juce::ParameterID{"phasy_type", 1}, "phasy_type",
+                                                              juce::StringArray{"phase", "gain", "smooth gain"}, 0);
+        ListenShared(*p, [this](float v) {
+            int const type = juce::roundToInt(v);
+            shared_params_.SetPhasyType(type == 0 ? phaser::PhasyType::kPhase : phaser::PhasyType::kGain,
+                                        type == 2 ? 0.2f : 0.0f);
+        });
+        layout.add(std::move(p));
+    }
+    {
+        auto p = std::make_unique<juce::AudioParameterChoice>(juce::ParameterID{"fft_size", 1}, "fft_size",
+                                                              juce::StringArray{"256", "512", "1024", "2048", "4096"}, 2);
+        param_listener_.Add(p, [this](int v) { mode_.fft_size = phaser::SpectralPhaser::kMinFftSize << v; });
+        layout.add(std::move(p));
+    }
+    {
+        auto p = std::make_unique<juce::AudioParameterChoice>(juce::ParameterID{"overlap", 1}, "overlap",
+                                                              juce::StringArray{"2", "4", "8"}, 1);
+        param_listener_.Add(p, [this](int v) { mode_.overlap = size_t{2} << v; });
+        layout.add(std::move(p));
+    }
+    {
+        auto p = std::make_unique<juce::AudioParameterChoice>(
+            juce::ParameterID{"window", 1}, "window",
+            juce::StringArray{"hann", "sqrt hann", "blackman harris", "kbd"}, 0);
+        param_listener_.Add(p, [this](int v) { mode_.window = static_cast<qwqdsp_window::Shape>(v); });
+        layout.add(std::move(p));
+    }
+    {
+        auto p = std::make_unique<juce::AudioParameterBool>(juce::ParameterID{"fft_auto", 1}, "fft_auto", false);
+        param_listener_.Add(p, [this](bool v) { mode_.scale_with_fs = v; });
+        layout.add(std::move(p));
+    }
+    {
+        auto p = std::make_unique<juce::AudioParameterBool>(juce::ParameterID{"multires", 1}, "multires", false);
+        param_listener_.Add(p, [this](bool v) { use_multires_ = v; });
+        layout.add(std::move(p));
+    }
+    {
+        // only the single resolution engine skips bins
+        auto p = std::make_unique<juce::AudioParameterBool>(juce::ParameterID{"sparse", 1}, "sparse", false);
+        param_listener_.Add(p, [this](bool v) { sparse_.enable = v; });
+        layout.add(std::move(p));
+    }
+    {
+        auto p = std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID{"sparse_threshold", 1}, "sparse_threshold",
+            juce::NormalisableRange<float>{-120.0f, -20.0f, 1.0f}, -60.0f);
+        param_listener_.Add(p, [this](float v) { sparse_.threshold_db = v; });
+        layout.add(std::move(p));
+    }
+    {
+        auto p = std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID{"sparse_low", 1}, "sparse_low",
+            juce::NormalisableRange<float>{0.0f, 20000.0f, 1.0f, 0.3f}, 0.0f);
+        param_listener_.Add(p, [this](float v) { sparse_.min_freq = v; });
+        layout.add(std::move(p));
+    }
+    {
+        auto p = std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID{"sparse_high", 1}, "sparse_high",
+            juce::NormalisableRange<float>{20.0f, 24000.0f, 1.0f, 0.3f}, 24000.0f);
+        // the top of the range is no limit at all, 88.2k and 96k have bands above it
+        param_listener_.Add(p, [this](float v) {
+            sparse_.max_freq = v >= 24000.0f ? std::numeric_limits<float>::infinity() : v;
+        });
         layout.add(std::move(p));
     }
 
     value_tree_ = std::make_unique<juce::AudioProcessorValueTreeState>(*this, nullptr, kParameterValueTreeIdentify,
                                                                        std::move(layout));
-    preset_manager_ = std::make_unique<pluginshared::PresetManager>(*value_tree_, *this, pluginshared::UpdateData::GithubInfo{
-        global::kPluginRepoOwnerName, global::kPluginRepoName
-    });
+    for (auto& l : shared_listeners_) {
+        l->param.addListener(l.get());
+        l->Push();
+    }
+    dsp_.SetParameters(&shared_params_);
+    multires_dsp_.SetParameters(&shared_params_);
+    dsp_.SetPerfCounters(&perf_);
+    dsp_.SetAnalyzer(&analyzer_);
+
+    for (auto* p : getParameters()) {
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(p)) {
+            // ids are ascii, hashed in place
+            state_params_.emplace_back(ranged, plugin_state::Hash(ranged->getParameterID().toRawUTF8()));
+        }
+    }
 }
 
 EmptyAudioProcessor::~EmptyAudioProcessor() {
+    for (auto& l : shared_listeners_) {
+        l->param.removeListener(l.get());
+    }
     param_listener_.Clear();
     preset_manager_ = nullptr;
     value_tree_ = nullptr;
 }
 
+void EmptyAudioProcessor::SharedListener::parameterValueChanged(int, float value) {
+    set(param.convertFrom0to1(value));
+}
+
+void EmptyAudioProcessor::SharedListener::Push() {
+    set(param.convertFrom0to1(param.getValue()));
+}
+
+void EmptyAudioProcessor::ListenShared(juce::RangedAudioParameter& param, std::function<void(float)> set) {
+    shared_listeners_.push_back(std::make_unique<SharedListener>(param, std::move(set)));
+}
+
+pluginshared::PresetManager& EmptyAudioProcessor::GetPresetManager() {
+    JUCE_ASSERT_MESSAGE_THREAD
+    // hosts create instances to scan and to restore projects, only an opened editor scans the presets
+    // and checks for updates
+    if (preset_manager_ == nullptr) {
+        preset_manager_ = std::make_unique<pluginshared::PresetManager>(
+            *value_tree_, *this,
+            pluginshared::UpdateData::GithubInfo{global::kPluginRepoOwnerName, global::kPluginRepoName});
+    }
+    return *preset_manager_;
+}
+
 //==============================================================================
 const juce::String EmptyAudioProcessor::getName() const {
     return JucePlugin_Name;
@@ -134,8 +264,20 @@ void EmptyAudioProcessor::changeProgramName(int index, const juce::String& newNa
 //==============================================================================
 void EmptyAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock) {
     float fs = static_cast<float>(sampleRate);
-    dsp_.Init(fs);
     param_listener_.MarkAll();
+    param_listener_.HandleDirty();
+    size_t const num_channels = static_cast<size_t>(getMainBusNumOutputChannels());
+    // worker threads only pay off on immersive buses, smaller ones stay on the audio thread
+    phaser::ParallelConfig parallel;
+    if (num_channels >= parallel.min_channels) {
+        parallel.num_workers = std::min<size_t>(3, std::thread::hardware_concurrency() / 2);
+    }
+    // only a new bus or worker count carves the buffers again, a new sample rate or block size does not allocate
+    dsp_.SetMode(mode_);
+    dsp_.Init(fs, num_channels, parallel);
+    multires_dsp_.Init(fs, num_channels);
+    multires_active_ = use_multires_;
+    UpdateLatency();
 }
 
 void EmptyAudioProcessor::releaseResources() {
@@ -143,17 +285,21 @@ void EmptyAudioProcessor::releaseResources() {
     // spare memory, etc.
 }
 
+void EmptyAudioProcessor::reset() {
+    // the host restarted or moved the transport, the frames of the old position are not overlap added
+    dsp_.Reset();
+    multires_dsp_.Reset();
+}
+
 bool EmptyAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const {
 #if JucePlugin_IsMidiEffect
     juce::ignoreUnused(layouts);
     return true;
 #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-        && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // mono, stereo, surround up to 7.1.4 and ambisonics up to third order, every channel gets the same
+    // masks, so any layout works as long as it fits
+    auto const& out = layouts.getMainOutputChannelSet();
+    if (out.isDisabled() || static_cast<size_t>(out.size()) > phaser::SpectralPhaser::kMaxChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -167,22 +313,84 @@ bool EmptyAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) con
 
 void EmptyAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
     juce::ScopedNoDenormals noDenormals;
+    uint64_t const begin = qwqdsp_perf::ReadCycles();
 
-    param_listener_.HandleDirty();
-
+    auto channels = BeginBlock(buffer);
     size_t const num_samples = static_cast<size_t>(buffer.getNumSamples());
-    float* left_ptr = buffer.getWritePointer(0);
-    float* right_ptr = buffer.getWritePointer(1);
 
     for (size_t i = 0; i < phaser::SpectralPhaser::kNumLayers; ++i) {
-        auto& layer = dsp_.GetLayer(i);
+        auto& layer = multires_active_ ? multires_dsp_.GetLayer(i) : dsp_.GetLayer(i);
         auto lfo = layer_lfo_[i].SyncBpm(getPlayHead(), layer.GetLfoPhase());
         layer.barber_freq = lfo.lfo_freq;
         layer.SetLfoPhase(lfo.lfo_phase);
     }
 
-    dsp_.Update();
-    dsp_.Process(left_ptr, right_ptr, num_samples);
+    // with nothing enabled or a silent input the engines skip the fft work on their own
+    if (multires_active_) {
+        multires_dsp_.Update();
+        multires_dsp_.Process(channels, num_samples);
+    }
+    else {
+        dsp_.Update();
+        dsp_.Process(channels, num_samples);
+    }
+
+    perf_.callback.Record(qwqdsp_perf::ReadCycles() - begin);
+    qwqdsp_perf::PerfCounters::Add(perf_.num_samples, num_samples);
+}
+
+void EmptyAudioProcessor::processBlockBypassed(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
+    juce::ScopedNoDenormals noDenormals;
+    uint64_t const begin = qwqdsp_perf::ReadCycles();
+
+    // delayed by the reported latency, so the host compensation stays right and coming back does not click
+    auto channels = BeginBlock(buffer);
+    size_t const num_samples = static_cast<size_t>(buffer.getNumSamples());
+    if (multires_active_) {
+        multires_dsp_.ProcessBypassed(channels, num_samples);
+    }
+    else {
+        dsp_.ProcessBypassed(channels, num_samples);
+    }
+
+    perf_.callback.Record(qwqdsp_perf::ReadCycles() - begin);
+    qwqdsp_perf::PerfCounters::Add(perf_.num_samples, num_samples);
+}
+
+// parameters, mode and engine changes of this block, returns the main bus laid out like prepareToPlay saw it
+std::span<float* const> EmptyAudioProcessor::BeginBlock(juce::AudioBuffer<float>& buffer) {
+    // a restore in progress keeps the parameters of the last block, it lands as a whole in a later one
+    uint32_t const seq = restore_seq_.load(std::memory_order_acquire);
+    if ((seq & 1) == 0) {
+        param_listener_.HandleDirty();
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (restore_seq_.load(std::memory_order_relaxed) != seq) {
+            // a restore started while reading, read everything again once it is done
+            param_listener_.MarkAll();
+        }
+    }
+    // every mode is preallocated, only the reported latency follows
+    bool latency_changed = dsp_.SetMode(mode_);
+    dsp_.SetSparse(sparse_);
+    if (use_multires_ != multires_active_) {
+        multires_active_ = use_multires_;
+        // the engine coming back still holds audio from the last time it ran
+        dsp_.Reset();
+        multires_dsp_.Reset();
+        latency_changed = true;
+    }
+    if (latency_changed) {
+        UpdateLatency();
+    }
+
+    size_t const num_channels = dsp_.GetNumChannels();
+    jassert(static_cast<size_t>(buffer.getNumChannels()) >= num_channels);
+    return {buffer.getArrayOfWritePointers(), num_channels};
+}
+
+void EmptyAudioProcessor::UpdateLatency() {
+    size_t const latency = multires_active_ ? multires_dsp_.GetLatency() : dsp_.GetLatency();
+    setLatencySamples(static_cast<int>(latency));
 }
 
 //==============================================================================
@@ -196,30 +404,77 @@ juce::AudioProcessorEditor* EmptyAudioProcessor::createEditor() {
 }
 
 //==============================================================================
+// no suspendProcessing(). every parameter is a single atomic load, so the capture is per parameter: automation
+// moving while saving may land in the state value by value. a restore on another thread is never mixed in, the
+// capture is taken again until none ran during it
 void EmptyAudioProcessor::getStateInformation(juce::MemoryBlock& destData) {
-    suspendProcessing(true);
-
-    juce::ValueTree plugin_state{"PLUGIN_STATE"};
-    plugin_state.appendChild(value_tree_->copyState(), nullptr);
-
-    if (auto xml = plugin_state.createXml(); xml != nullptr) {
-        copyXmlToBinary(*xml, destData);
+    std::vector<plugin_state::Entry> entries;
+    entries.reserve(state_params_.size());
+    for (;;) {
+        uint32_t const seq = restore_seq_.load(std::memory_order_acquire);
+        if ((seq & 1) != 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        entries.clear();
+        for (auto const& [param, hash] : state_params_) {
+            entries.push_back({hash, param->convertFrom0to1(param->getValue())});
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (restore_seq_.load(std::memory_order_relaxed) == seq) break;
     }
 
-    suspendProcessing(false);
+    auto const data = plugin_state::Encode(entries);
+    destData.replaceAll(data.data(), data.size());
 }
 
 void EmptyAudioProcessor::setStateInformation(const void* data, int sizeInBytes) {
-    suspendProcessing(true);
+    std::vector<plugin_state::Entry> entries;
+    size_t const size = static_cast<size_t>(sizeInBytes);
+    if (plugin_state::Decode(data, size, entries)) {
+        RestoreState(entries);
+    }
+    else if (!plugin_state::IsState(data, size)) {
+        ImportXmlState(data, sizeInBytes);
+    }
+    // a state of a version this build does not know leaves the parameters as they are
+}
 
-    auto xml = *getXmlFromBinary(data, sizeInBytes);
-    auto plugin_state = juce::ValueTree::fromXml(xml);
-    if (plugin_state.isValid()) {
-        auto parameter = plugin_state.getChildWithName(kParameterValueTreeIdentify);
-        value_tree_->replaceState(parameter);
+// parameters missing from the state go back to their default, like replaceState() did
+void EmptyAudioProcessor::RestoreState(std::span<plugin_state::Entry const> entries) {
+    restore_seq_.fetch_add(1, std::memory_order_acq_rel);
+    shared_params_.Hold();
+    for (auto const& [param, hash] : state_params_) {
+        float value = param->getDefaultValue();
+        for (auto const& e : entries) {
+            if (e.id_hash == hash) {
+                value = param->convertTo0to1(e.value);
+                break;
+            }
+        }
+        param->setValueNotifyingHost(value);
     }
+    shared_params_.Release();
+    restore_seq_.fetch_add(1, std::memory_order_release);
+}
 
-    suspendProcessing(false);
+// sessions saved before the binary state, a PLUGIN_STATE xml holding the PARAMETERS tree
+bool EmptyAudioProcessor::ImportXmlState(const void* data, int sizeInBytes) {
+    auto xml = getXmlFromBinary(data, sizeInBytes);
+    if (xml == nullptr) return false;
+    auto* parameters = xml->hasTagName(kParameterValueTreeIdentify) ? xml.get()
+                                                                     : xml->getChildByName(kParameterValueTreeIdentify);
+    if (parameters == nullptr) return false;
+
+    std::vector<plugin_state::Entry> entries;
+    for (auto* param : parameters->getChildIterator()) {
+        if (param->hasAttribute("id") && param->hasAttribute("value")) {
+            entries.push_back({plugin_state::Hash(param->getStringAttribute("id").toStdString()),
+                               static_cast<float>(param->getDoubleAttribute("value"))});
+        }
+    }
+    RestoreState(entries);
+    return true;
 }
 
 //==============================================================================
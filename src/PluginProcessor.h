@@ -5,6 +5,8 @@
 #include "pluginshared/bpm_sync_lfo.hpp"
 
 #include "dsp/phaser.hpp"
+#include "dsp/multires_phaser.hpp"
+#include "plugin_state.hpp"
 
 class EmptyAudioProcessor final : public juce::AudioProcessor {
 public:
@@ -16,11 +18,14 @@ public:
     //==============================================================================
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
+    void reset() override;
 
     bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
 
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
     using AudioProcessor::processBlock;
+    void processBlockBypassed(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    using AudioProcessor::processBlockBypassed;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -45,13 +50,60 @@ public:
     void getStateInformation(juce::MemoryBlock& destData) override;
     void setStateInformation(const void* data, int sizeInBytes) override;
 
+    /**
+     * @brief created by the first call, message thread only
+     */
+    pluginshared::PresetManager& GetPresetManager();
+
     JuceParamListener param_listener_;
     std::unique_ptr<juce::AudioProcessorValueTreeState> value_tree_;
-    std::unique_ptr<pluginshared::PresetManager> preset_manager_;
 
+    // the layer parameters, written by shared_listeners_, both engines copy them once per hop
+    phaser::SharedParameters shared_params_;
     phaser::SpectralPhaser dsp_;
+    phaser::MultiResolutionPhaser multires_dsp_;
     pluginshared::BpmSyncLFO layer_lfo_[phaser::SpectralPhaser::kNumLayers];
+    // written by the audio thread, PerfOverlay reads it
+    qwqdsp_perf::PerfCounters perf_;
+    // filled by dsp_ while a SpectrumView is open
+    phaser::AnalyzerTap analyzer_;
 private:
+    // writes one parameter into shared_params_ on the thread that changed it, HandleDirty() never sees it
+    struct SharedListener final : juce::AudioProcessorParameter::Listener {
+        SharedListener(juce::RangedAudioParameter& p, std::function<void(float)> f)
+            : param(p)
+            , set(std::move(f)) {}
+
+        void parameterValueChanged(int, float) override;
+        void parameterGestureChanged(int, bool) override {}
+        // the current value, in the units of the parameter
+        void Push();
+
+        juce::RangedAudioParameter& param;
+        std::function<void(float)> set;
+    };
+
+    void ListenShared(juce::RangedAudioParameter& param, std::function<void(float)> set);
+    std::span<float* const> BeginBlock(juce::AudioBuffer<float>& buffer);
+    void UpdateLatency();
+    void RestoreState(std::span<plugin_state::Entry const> entries);
+    bool ImportXmlState(const void* data, int sizeInBytes);
+
+    std::unique_ptr<pluginshared::PresetManager> preset_manager_;
+    // the layer and phasy parameters, registered with the parameters once value_tree_ holds them
+    std::vector<std::unique_ptr<SharedListener>> shared_listeners_;
+    // every parameter of value_tree_ with the hash of its id, in layout order
+    std::vector<std::pair<juce::RangedAudioParameter*, uint32_t>> state_params_;
+    // odd while setStateInformation() writes the parameters, the audio thread does not pick up half of them
+    std::atomic<uint32_t> restore_seq_{};
+
+    // written by the parameter listener, handed to dsp_ once per block
+    phaser::SpectralPhaser::Mode mode_;
+    phaser::SpectralPhaser::Sparse sparse_;
+    bool use_multires_{};
+    // the engine processBlock runs, only follows use_multires_ at block boundaries
+    bool multires_active_{};
+
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EmptyAudioProcessor)
 };
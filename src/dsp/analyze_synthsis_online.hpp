@@ -1,127 +1,364 @@
 #pragma once
 #include <algorithm>
+#include <bit>
+#include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <span>
-#include <vector>
+
+#include "arena.hpp"
 
 namespace qwqdsp_segement {
+/**
+ * @brief stft segementer on ring buffers, latency is size - 1 samples
+ * @note every input sample is written once, every output sample is read once, the frame
+ *       is only linearized (and windowed) once per hop. the channels of a buffer are laid out
+ *       one after another
+ */
 class AnalyzeSynthsisOnline {
 public:
     /**
-     * @tparam Func void(std::span<float const> left, std::span<float const> right, std::span<float> left_out,
-     *                   std::span<float> left_right)
+     * @tparam Func void(std::span<float const* const> in, std::span<float* const> out), one frame of
+     *              GetSize() samples per channel
+     * @param channels GetNumChannels() pointers, every one num_samples long
+     * @note in is already multiplied by the analyze window, out is multiplied by the synthsis window
+     *       before overlap add. func is not called when every frame is silent, out of a channel with
+     *       IsFrameSilent() is not read
      */
     template <class Func>
-    void Process(std::span<float> left_block, std::span<float> right_block, Func&& func) noexcept(
-        noexcept(func(std::declval<std::span<float const>>(), std::declval<std::span<float const>>(),
-                      std::declval<std::span<float>>(), std::declval<std::span<float>>()))) {
+    void Process(std::span<float* const> channels, size_t num_samples, Func&& func) noexcept(
+        noexcept(func(std::declval<std::span<float const* const>>(), std::declval<std::span<float* const>>()))) {
+        Run<false>(channels, num_samples, func);
+    }
+
+    /**
+     * @brief every frame passes unchanged, the output is the input delayed by GetLatency() and scaled by the
+     *        overlap add gain of the windows, about one multiply per sample
+     * @note can take turns with Process() at any block, the frames in flight are completed like the
+     *       other one would have done
+     */
+    void ProcessPassthrough(std::span<float* const> channels, size_t num_samples) noexcept {
+        auto nothing = [](std::span<float const* const>, std::span<float* const>) noexcept {};
+        Run<true>(channels, num_samples, nothing);
+    }
+
+    /**
+     * @return true if every sample in the current frame of the channel is zero, valid inside the func of Process()
+     */
+    bool IsFrameSilent(size_t ch) const noexcept {
+        return zero_run_[ch] >= size_;
+    }
+
+    /**
+     * @brief takes the rings and frames for up to max_size and max_hop from arena, call it inside
+     *        qwqdsp_memory::Arena::Carve() and SetSize(), SetHop() after it
+     */
+    void Carve(qwqdsp_memory::Arena& arena, size_t num_channels, size_t max_size, size_t max_hop) noexcept {
+        num_channels_ = num_channels;
+        frame_stride_ = max_size;
+        output_stride_ = max_size + max_hop;
+        input_buffer_ = arena.Take<float>(num_channels * frame_stride_);
+        process_buffer_ = arena.Take<float>(num_channels * frame_stride_);
+        output_frame_buffer_ = arena.Take<float>(num_channels * frame_stride_);
+        output_buffer_ = arena.Take<float>(num_channels * output_stride_);
+        process_frames_ = arena.Take<float const*>(num_channels);
+        output_frames_ = arena.Take<float*>(num_channels);
+        passthrough_gain_ = arena.Take<float>(frame_stride_);
+        zero_run_ = arena.Take<size_t>(num_channels);
+    }
+
+    /**
+     * @param size at most the max_size of Carve(), does not allocate
+     */
+    void SetSize(size_t size) noexcept {
+        assert(size <= frame_stride_);
+        size_ = size;
+        Layout();
+    }
+
+    /**
+     * @param hop at most the max_hop of Carve(), does not allocate
+     */
+    void SetHop(size_t hop) noexcept {
+        assert(size_ + hop <= output_stride_);
+        hop_ = hop;
+        Layout();
+    }
+
+    /**
+     * @param analyze empty for rectangle, or size
+     * @param synthsis empty for rectangle, or size
+     * @note the spans are referenced, not copied. call it after SetSize() and SetHop()
+     */
+    void SetWindow(std::span<float const> analyze, std::span<float const> synthsis) noexcept {
+        analyze_window_ = analyze;
+        synthsis_window_ = synthsis;
+
+        // sum of analyze * synthsis over the frames that already passed frame position d
+        for (size_t d = 0; d < size_; ++d) {
+            float const a = analyze.empty() ? 1.0f : analyze[d];
+            float const s = synthsis.empty() ? 1.0f : synthsis[d];
+            passthrough_gain_[d] = a * s + (d >= hop_ ? passthrough_gain_[d - hop_] : 0.0f);
+        }
+    }
+
+    size_t GetNumChannels() const noexcept {
+        return num_channels_;
+    }
+
+    size_t GetSize() const noexcept {
+        return size_;
+    }
+
+    size_t GetLatency() const noexcept {
+        return size_ - 1;
+    }
+
+    void Reset() noexcept {
+        for (size_t ch = 0; ch < num_channels_; ++ch) {
+            std::fill_n(InputRing(ch), size_, 0.0f);
+            std::fill_n(OutputRing(ch), output_size_, 0.0f);
+        }
+        std::fill(zero_run_.begin(), zero_run_.end(), size_);
+        input_wpos_ = 0;
+        hop_counter_ = 0;
+        output_rpos_ = 0;
+        output_pending_ = 0;
+        passthrough_ = false;
+    }
+private:
+    template <bool kPassthrough, class Func>
+    void Run(std::span<float* const> channels, size_t num_samples, Func& func) noexcept(
+        noexcept(func(std::declval<std::span<float const* const>>(), std::declval<std::span<float* const>>()))) {
+        assert(channels.size() == num_channels_);
+        if (SkipSilence(channels, num_samples)) return;
+
         size_t in_wrpos = 0;
-        size_t const in_size = left_block.size();
-
-        while (in_wrpos != in_size) {
-            size_t need = size_ - input_wpos_;
-            size_t can_read = std::min(need, in_size - in_wrpos);
-            std::copy_n(left_block.begin() + static_cast<int>(in_wrpos), can_read,
-                        input_buffer_left_.begin() + static_cast<int>(input_wpos_));
-            std::copy_n(right_block.begin() + static_cast<int>(in_wrpos), can_read,
-                        input_buffer_right_.begin() + static_cast<int>(input_wpos_));
+        while (in_wrpos != num_samples) {
+            size_t const can_read = std::min(hop_ - hop_counter_, num_samples - in_wrpos);
+            for (size_t ch = 0; ch < num_channels_; ++ch) {
+                WriteRing(InputRing(ch), channels[ch] + in_wrpos, can_read);
+                CountZeros(ch, channels[ch] + in_wrpos, can_read);
+            }
             input_wpos_ += can_read;
+            if (input_wpos_ >= size_) input_wpos_ -= size_;
+            hop_counter_ += can_read;
 
-            if (input_wpos_ >= size_) {
-                func(std::span<float const>{input_buffer_left_.data(), size_},
-                     std::span<float const>{input_buffer_right_.data(), size_},
-                     std::span<float>{process_buffer_left_.data(), size_},
-                     std::span<float>{process_buffer_right_.data(), size_});
+            if (hop_counter_ == hop_) {
+                hop_counter_ = 0;
 
-                input_wpos_ -= hop_;
-                for (size_t i = 0; i < input_wpos_; i++) {
-                    input_buffer_left_[i] = input_buffer_left_[i + hop_];
-                }
-                for (size_t i = 0; i < input_wpos_; i++) {
-                    input_buffer_right_[i] = input_buffer_right_[i + hop_];
+                // frame[0] comes out together with the last sample of this chunk
+                size_t add_pos = output_rpos_ + can_read - 1;
+                if (add_pos >= output_size_) add_pos -= output_size_;
+                bool const all_silent = std::all_of(zero_run_.begin(), zero_run_.end(),
+                                                    [this](size_t n) { return n >= size_; });
+                // a silent frame adds nothing either way, so it does not change passthrough_ either
+                if (!all_silent) {
+                    if constexpr (kPassthrough) {
+                        Passthrough(add_pos);
+                    }
+                    else {
+                        ProcessFrame(add_pos, func);
+                    }
+                    output_pending_ = std::max(output_pending_, can_read - 1 + size_);
                 }
+            }
 
-                for (size_t i = 0; i < size_; i++) {
-                    output_buffer_left_[i + write_add_end_] += process_buffer_left_[i];
-                }
-                for (size_t i = 0; i < size_; i++) {
-                    output_buffer_right_[i + write_add_end_] += process_buffer_right_[i];
-                }
-                write_add_end_ += hop_;
-                write_end_ = write_add_end_ + size_;
+            for (size_t ch = 0; ch < num_channels_; ++ch) {
+                ExtractOutput(OutputRing(ch), channels[ch] + in_wrpos, can_read);
             }
+            output_rpos_ += can_read;
+            if (output_rpos_ >= output_size_) output_rpos_ -= output_size_;
+            output_pending_ -= std::min(output_pending_, can_read);
 
-            if (write_add_end_ >= can_read) {
-                // extract output
-                size_t extractSize = can_read;
-                for (size_t i = 0; i < extractSize; ++i) {
-                    left_block[i + in_wrpos] = output_buffer_left_[i];
-                    output_buffer_left_[i] = 0;
-                }
-                for (size_t i = 0; i < extractSize; ++i) {
-                    right_block[i + in_wrpos] = output_buffer_right_[i];
-                    output_buffer_right_[i] = 0;
-                }
+            in_wrpos += can_read;
+        }
+    }
 
-                // shift output buffer
-                size_t shiftSize = write_end_ - extractSize;
-                for (size_t i = 0; i < shiftSize; i++) {
-                    output_buffer_left_[i] = output_buffer_left_[i + extractSize];
-                }
-                for (size_t i = 0; i < shiftSize; i++) {
-                    output_buffer_right_[i] = output_buffer_right_[i + extractSize];
-                }
-                write_add_end_ -= extractSize;
-                write_end_ = write_add_end_ + size_;
+    template <class Func>
+    void ProcessFrame(size_t add_pos, Func& func) noexcept(
+        noexcept(func(std::declval<std::span<float const* const>>(), std::declval<std::span<float* const>>()))) {
+        for (size_t ch = 0; ch < num_channels_; ++ch) {
+            ReadFrame(InputRing(ch), process_buffer_.data() + ch * frame_stride_);
+        }
+
+        func(std::span<float const* const>{process_frames_.data(), num_channels_},
+             std::span<float* const>{output_frames_.data(), num_channels_});
+
+        for (size_t ch = 0; ch < num_channels_; ++ch) {
+            if (IsFrameSilent(ch)) continue;
+            if (passthrough_) {
+                // the frames before this one were passed through, only keep their own part
+                AddPassthrough(ch, add_pos, 0, size_ - hop_, -1.0f);
             }
-            else {
-                // zero buffer
-                std::fill_n(left_block.begin() + static_cast<int>(in_wrpos), can_read, 0.0f);
-                std::fill_n(right_block.begin() + static_cast<int>(in_wrpos), can_read, 0.0f);
+            OverlapAdd(OutputRing(ch), output_frames_[ch], add_pos);
+        }
+        passthrough_ = false;
+    }
+
+    /**
+     * @brief the output ring always holds the finished output up to the end of the newest frame, so the
+     *        first passed through frame completes the frames in flight and later ones only add their last hop
+     */
+    void Passthrough(size_t add_pos) noexcept {
+        size_t const begin = passthrough_ ? size_ - hop_ : 0;
+        for (size_t ch = 0; ch < num_channels_; ++ch) {
+            if (IsFrameSilent(ch)) continue;
+            AddPassthrough(ch, add_pos, begin, size_, 1.0f);
+        }
+        passthrough_ = true;
+    }
+
+    // unwindowed input of frame positions [begin, end) times passthrough_gain_
+    void AddPassthrough(size_t ch, size_t add_pos, size_t begin, size_t end, float scale) noexcept {
+        float const* in = InputRing(ch);
+        float* out = OutputRing(ch);
+        size_t rpos = input_wpos_ + begin;
+        if (rpos >= size_) rpos -= size_;
+        size_t wpos = add_pos + begin;
+        if (wpos >= output_size_) wpos -= output_size_;
+        for (size_t d = begin; d < end; ++d) {
+            out[wpos] += scale * passthrough_gain_[d] * in[rpos];
+            if (++rpos == size_) rpos = 0;
+            if (++wpos == output_size_) wpos = 0;
+        }
+    }
+
+    /**
+     * @brief digital silence in, nothing left to overlap add and the rings are all zero, so the silent
+     *        input already is the output
+     */
+    bool SkipSilence(std::span<float* const> channels, size_t num_samples) noexcept {
+        if (output_pending_ != 0) return false;
+        for (size_t ch = 0; ch < num_channels_; ++ch) {
+            if (!IsFrameSilent(ch)) return false;
+            if (std::any_of(channels[ch], channels[ch] + num_samples, [](float x) { return !IsZero(x); })) {
+                return false;
             }
+        }
+        input_wpos_ = (input_wpos_ + num_samples) % size_;
+        hop_counter_ = (hop_counter_ + num_samples) % hop_;
+        output_rpos_ = (output_rpos_ + num_samples) % output_size_;
+        return true;
+    }
 
-            in_wrpos += can_read;
+    // +0 or -0, only the sign bit may be set
+    static bool IsZero(float x) noexcept {
+        return (std::bit_cast<uint32_t>(x) << 1) == 0;
+    }
+
+    void CountZeros(size_t ch, float const* x, size_t n) noexcept {
+        size_t i = n;
+        while (i != 0 && IsZero(x[i - 1])) {
+            --i;
         }
+        zero_run_[ch] = i == 0 ? std::min(zero_run_[ch] + n, size_) : n - i;
     }
 
-    void SetSize(size_t size) noexcept {
-        size_ = size;
-        if (input_buffer_left_.size() < size) {
-            input_buffer_left_.resize(size);
-            input_buffer_right_.resize(size);
+    // the strides stay the ones of Carve(), any smaller size or hop fits in them
+    void Layout() noexcept {
+        output_size_ = size_ + hop_;
+        for (size_t ch = 0; ch < num_channels_; ++ch) {
+            process_frames_[ch] = process_buffer_.data() + ch * frame_stride_;
+            output_frames_[ch] = output_frame_buffer_.data() + ch * frame_stride_;
         }
-        if (output_buffer_left_.size() < (size + hop_) * 2) {
-            output_buffer_left_.resize((size + hop_) * 2);
-            output_buffer_right_.resize((size + hop_) * 2);
+        Reset();
+    }
+
+    float* InputRing(size_t ch) noexcept {
+        return input_buffer_.data() + ch * frame_stride_;
+    }
+
+    float* OutputRing(size_t ch) noexcept {
+        return output_buffer_.data() + ch * output_stride_;
+    }
+
+    void WriteRing(float* ring, float const* x, size_t n) noexcept {
+        size_t const first = std::min(n, size_ - input_wpos_);
+        std::copy_n(x, first, ring + input_wpos_);
+        std::copy_n(x + first, n - first, ring);
+    }
+
+    // oldest sample first, the oldest one is the next to be overwritten
+    void ReadFrame(float const* ring, float* frame) noexcept {
+        size_t const first = size_ - input_wpos_;
+        float const* tail = ring + input_wpos_;
+        if (analyze_window_.empty()) {
+            std::copy_n(tail, first, frame);
+            std::copy_n(ring, input_wpos_, frame + first);
         }
-        if (process_buffer_left_.size() < size) {
-            process_buffer_left_.resize(size);
-            process_buffer_right_.resize(size);
+        else {
+            float const* w = analyze_window_.data();
+            for (size_t i = 0; i < first; ++i) {
+                frame[i] = tail[i] * w[i];
+            }
+            w += first;
+            frame += first;
+            for (size_t i = 0; i < input_wpos_; ++i) {
+                frame[i] = ring[i] * w[i];
+            }
         }
     }
 
-    void SetHop(size_t hop) noexcept {
-        hop_ = hop;
+    void OverlapAdd(float* ring, float const* frame, size_t pos) noexcept {
+        size_t const first = std::min(size_, output_size_ - pos);
+        size_t const second = size_ - first;
+        float* head = ring + pos;
+        if (synthsis_window_.empty()) {
+            for (size_t i = 0; i < first; ++i) {
+                head[i] += frame[i];
+            }
+            frame += first;
+            for (size_t i = 0; i < second; ++i) {
+                ring[i] += frame[i];
+            }
+        }
+        else {
+            float const* w = synthsis_window_.data();
+            for (size_t i = 0; i < first; ++i) {
+                head[i] += frame[i] * w[i];
+            }
+            frame += first;
+            w += first;
+            for (size_t i = 0; i < second; ++i) {
+                ring[i] += frame[i] * w[i];
+            }
+        }
     }
 
-    void Reset() noexcept {
-        std::fill_n(output_buffer_left_.begin(), write_end_, 0.0f);
-        std::fill_n(output_buffer_right_.begin(), write_end_, 0.0f);
-        input_wpos_ = 0;
-        write_end_ = 0;
-        write_add_end_ = 0;
+    void ExtractOutput(float* ring, float* y, size_t n) noexcept {
+        size_t const first = std::min(n, output_size_ - output_rpos_);
+        float* head = ring + output_rpos_;
+        std::copy_n(head, first, y);
+        std::fill_n(head, first, 0.0f);
+        std::copy_n(ring, n - first, y + first);
+        std::fill_n(ring, n - first, 0.0f);
     }
-private:
-    std::vector<float> input_buffer_left_;
-    std::vector<float> input_buffer_right_;
-    std::vector<float> process_buffer_left_;
-    std::vector<float> process_buffer_right_;
-    std::vector<float> output_buffer_left_;
-    std::vector<float> output_buffer_right_;
+
+    // carved from the arena of the owner, channel ch of a buffer starts at ch * stride
+    std::span<float> input_buffer_;
+    std::span<float> process_buffer_;
+    std::span<float> output_frame_buffer_;
+    std::span<float> output_buffer_;
+    std::span<float const*> process_frames_;
+    std::span<float*> output_frames_;
+    std::span<float const> analyze_window_;
+    std::span<float const> synthsis_window_;
+    std::span<float> passthrough_gain_;
+    // trailing zero input samples of every channel, at most size_
+    std::span<size_t> zero_run_;
+    size_t num_channels_{};
     size_t size_{};
     size_t hop_{};
+    size_t output_size_{};
+    size_t frame_stride_{};
+    size_t output_stride_{};
     size_t input_wpos_{};
-    size_t write_end_{};
-    size_t write_add_end_{};
+    size_t hop_counter_{};
+    size_t output_rpos_{};
+    // samples from output_rpos_ on that may still hold something
+    size_t output_pending_{};
+    // the last frame that was not silent went through Passthrough()
+    bool passthrough_{};
 };
 } // namespace qwqdsp_segement
@@ -0,0 +1,115 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+
+namespace qwqdsp_memory {
+
+static constexpr size_t kCacheLine = 64;
+
+constexpr size_t PadToCacheLine(size_t bytes) noexcept {
+    return (bytes + kCacheLine - 1) / kCacheLine * kCacheLine;
+}
+
+/**
+ * @brief where the memory of one engine instance is
+ */
+struct Footprint {
+    // the engine objects, fixed size state, fft objects and layer caches
+    size_t object_bytes{};
+    // the arena, every buffer the stft works on
+    size_t arena_bytes{};
+    // pieces carved from the arena
+    size_t num_buffers{};
+    // fft objects, their twiddles are shared by every instance and their work buffers are not counted
+    size_t num_ffts{};
+
+    size_t TotalBytes() const noexcept {
+        return object_bytes + arena_bytes;
+    }
+
+    Footprint& operator+=(Footprint const& other) noexcept {
+        object_bytes += other.object_bytes;
+        arena_bytes += other.arena_bytes;
+        num_buffers += other.num_buffers;
+        num_ffts += other.num_ffts;
+        return *this;
+    }
+};
+
+/**
+ * @brief one cache line aligned block that every buffer of an instance is carved from
+ * @note Carve() runs the carving twice, the first run only counts the bytes. then the block is allocated, only
+ *       when it has to grow, and zeroed, and the second run hands out the pieces. every piece starts on a cache
+ *       line of its own, so neither two buffers nor two instances share one
+ */
+class Arena {
+public:
+    /**
+     * @tparam Func void(Arena&), may only call Take(), the same way both times. the spans are empty while counting
+     * @note not realtime safe
+     */
+    template <class Func>
+    void Carve(Func&& carve) {
+        counting_ = true;
+        used_ = 0;
+        num_pieces_ = 0;
+        carve(*this);
+        size_t const counted = used_;
+        if (counted > capacity_) {
+            block_.reset(static_cast<std::byte*>(::operator new(counted, std::align_val_t{kCacheLine})));
+            capacity_ = counted;
+        }
+        if (counted != 0) std::memset(block_.get(), 0, counted);
+
+        counting_ = false;
+        used_ = 0;
+        num_pieces_ = 0;
+        carve(*this);
+        assert(used_ == counted);
+    }
+
+    /**
+     * @return count zeroed elements starting on a cache line, the rest of the last line is left unused
+     */
+    template <class T>
+    std::span<T> Take(size_t count) noexcept {
+        static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= kCacheLine);
+        size_t const offset = used_;
+        used_ += PadToCacheLine(count * sizeof(T));
+        ++num_pieces_;
+        if (counting_) return {};
+        return {reinterpret_cast<T*>(block_.get() + offset), count};
+    }
+
+    // bytes the last Carve() handed out
+    size_t GetSize() const noexcept {
+        return used_;
+    }
+
+    size_t GetCapacity() const noexcept {
+        return capacity_;
+    }
+
+    size_t GetNumPieces() const noexcept {
+        return num_pieces_;
+    }
+private:
+    struct Free {
+        void operator()(std::byte* p) const noexcept {
+            ::operator delete(p, std::align_val_t{kCacheLine});
+        }
+    };
+
+    std::unique_ptr<std::byte[], Free> block_;
+    size_t capacity_{};
+    size_t used_{};
+    size_t num_pieces_{};
+    bool counting_{};
+};
+
+} // namespace qwqdsp_memory
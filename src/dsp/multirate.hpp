@@ -0,0 +1,196 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+#include <span>
+#include <vector>
+
+#include "simd.hpp"
+
+namespace qwqdsp_multirate {
+
+/**
+ * @param n multiple of qwqdsp_simd::Native::kWidth
+ */
+inline float Dot(float const* a, float const* b, size_t n) noexcept {
+    using V = qwqdsp_simd::Native;
+    auto sum0 = V::Set(0.0f);
+    auto sum1 = V::Set(0.0f);
+    size_t i = 0;
+    for (; i + 2 * V::kWidth <= n; i += 2 * V::kWidth) {
+        sum0 = V::MulAdd(V::Load(a + i), V::Load(b + i), sum0);
+        sum1 = V::MulAdd(V::Load(a + i + V::kWidth), V::Load(b + i + V::kWidth), sum1);
+    }
+    if (i != n) {
+        sum0 = V::MulAdd(V::Load(a + i), V::Load(b + i), sum0);
+    }
+    alignas(64) float lanes[V::kWidth];
+    V::Store(lanes, V::Add(sum0, sum1));
+    float sum = 0;
+    for (float x : lanes) {
+        sum += x;
+    }
+    return sum;
+}
+
+// zero padded taps of a fir, so Dot() needs no tail
+inline size_t PadTaps(size_t n) noexcept {
+    constexpr size_t kWidth = qwqdsp_simd::Native::kWidth;
+    return (n + kWidth - 1) / kWidth * kWidth;
+}
+
+/**
+ * @brief blackman windowed sinc lowpass, dc gain is 1
+ * @param h odd size, group delay is (size - 1) / 2
+ * @param cutoff -6dB point, normalized to fs
+ */
+inline void DesignLowpass(std::span<float> h, float cutoff) noexcept {
+    size_t const n = h.size();
+    double const center = static_cast<double>(n - 1) / 2.0;
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double const t = static_cast<double>(i) - center;
+        // t == 0 at the centre tap of an odd size
+        double const sinc = 2 * i + 1 == n ? 2.0 * cutoff
+                                           : std::sin(2.0 * std::numbers::pi * cutoff * t) / (std::numbers::pi * t);
+        double const phase = 2.0 * std::numbers::pi * static_cast<double>(i) / static_cast<double>(n - 1);
+        double const window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+        h[i] = static_cast<float>(sinc * window);
+        sum += sinc * window;
+    }
+    for (auto& x : h) {
+        x = static_cast<float>(x / sum);
+    }
+}
+
+/**
+ * @brief fir lowpass then keep every factor-th sample
+ * @note runs on the same sample clock as Interpolator, a decimator and an interpolator
+ *       that were reset together and see the same block sizes stay in phase
+ */
+class Decimator {
+public:
+    void Init(std::span<float const> coeffs, size_t factor) {
+        // oldest first, the padding goes to the oldest end
+        coeffs_.assign(PadTaps(coeffs.size()), 0.0f);
+        std::copy(coeffs.rbegin(), coeffs.rend(), coeffs_.end() - static_cast<std::ptrdiff_t>(coeffs.size()));
+        factor_ = factor;
+        history_.resize(coeffs_.size() * 2);
+        Reset();
+    }
+
+    void Reset() noexcept {
+        std::fill(history_.begin(), history_.end(), 0.0f);
+        wpos_ = 0;
+        phase_ = 0;
+    }
+
+    /**
+     * @return number of samples written to y, at most ceil(num_samples / factor)
+     */
+    size_t Process(float const* x, float* y, size_t num_samples) noexcept {
+        size_t const size = coeffs_.size();
+        size_t num_out = 0;
+        for (size_t i = 0; i < num_samples; ++i) {
+            // every sample is stored twice, the newest size samples are always contiguous
+            history_[wpos_] = x[i];
+            history_[wpos_ + size] = x[i];
+            if (++wpos_ == size) wpos_ = 0;
+
+            if (phase_ == 0) {
+                y[num_out++] = Dot(history_.data() + wpos_, coeffs_.data(), size);
+            }
+            if (++phase_ == factor_) phase_ = 0;
+        }
+        return num_out;
+    }
+private:
+    std::vector<float> coeffs_;
+    std::vector<float> history_;
+    size_t factor_{};
+    size_t wpos_{};
+    size_t phase_{};
+};
+
+/**
+ * @brief insert factor-1 zeros after every sample then fir lowpass, polyphase
+ */
+class Interpolator {
+public:
+    void Init(std::span<float const> coeffs, size_t factor) {
+        factor_ = factor;
+        taps_ = PadTaps((coeffs.size() + factor - 1) / factor);
+        // phase j holds coeffs[j + k * factor] for the k-th newest input, oldest first
+        coeffs_.assign(taps_ * factor, 0.0f);
+        for (size_t j = 0; j < factor; ++j) {
+            for (size_t k = 0; k < taps_; ++k) {
+                size_t const idx = j + k * factor;
+                if (idx < coeffs.size()) {
+                    coeffs_[j * taps_ + taps_ - 1 - k] = coeffs[idx] * static_cast<float>(factor);
+                }
+            }
+        }
+        history_.resize(taps_ * 2);
+        Reset();
+    }
+
+    void Reset() noexcept {
+        std::fill(history_.begin(), history_.end(), 0.0f);
+        wpos_ = 0;
+        phase_ = 0;
+    }
+
+    /**
+     * @param x one sample is consumed every factor output samples
+     * @param y num_samples
+     */
+    void Process(float const* x, float* y, size_t num_samples) noexcept {
+        for (size_t i = 0; i < num_samples; ++i) {
+            if (phase_ == 0) {
+                history_[wpos_] = *x;
+                history_[wpos_ + taps_] = *x;
+                ++x;
+                if (++wpos_ == taps_) wpos_ = 0;
+            }
+
+            y[i] = Dot(history_.data() + wpos_, coeffs_.data() + phase_ * taps_, taps_);
+            if (++phase_ == factor_) phase_ = 0;
+        }
+    }
+private:
+    std::vector<float> coeffs_;
+    std::vector<float> history_;
+    size_t factor_{};
+    size_t taps_{};
+    size_t wpos_{};
+    size_t phase_{};
+};
+
+class Delay {
+public:
+    void Init(size_t delay) {
+        delay_ = delay;
+        buffer_.resize(delay);
+        Reset();
+    }
+
+    void Reset() noexcept {
+        std::fill(buffer_.begin(), buffer_.end(), 0.0f);
+        pos_ = 0;
+    }
+
+    void Process(float* x, size_t num_samples) noexcept {
+        if (delay_ == 0) return;
+        for (size_t i = 0; i < num_samples; ++i) {
+            std::swap(x[i], buffer_[pos_]);
+            if (++pos_ == delay_) pos_ = 0;
+        }
+    }
+private:
+    std::vector<float> buffer_;
+    size_t delay_{};
+    size_t pos_{};
+};
+
+} // namespace qwqdsp_multirate
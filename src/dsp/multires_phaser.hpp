@@ -0,0 +1,411 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#include "multirate.hpp"
+#include "phaser.hpp"
+
+namespace phaser {
+
+/**
+ * @brief splits the input into up to three bands and runs every band through its own stft,
+ *        low notches get long windows while the highs keep a short one
+ * @note band b runs at fs / kDecimation^b. a band only keeps what the bands below it can not
+ *       reconstruct, so with every layer disabled the output is the input delayed by GetLatency()
+ *       and scaled like SpectralPhaser
+ */
+class MultiResolutionPhaser {
+public:
+    static constexpr size_t kMaxBands = 3;
+    static constexpr size_t kDecimation = 4;
+    static constexpr size_t kNumLayers = SpectralPhaser::kNumLayers;
+    // blackman windowed sinc, the transition band is fs / (4 * kDecimation) wide
+    static constexpr size_t kFilterSize = 22 * kDecimation + 1;
+    // the top band is processed in blocks of this many samples
+    static constexpr size_t kBlockSize = 256;
+
+    struct Config {
+        size_t num_bands = 3;
+        // at the sample rate of each band, top band first
+        std::array<size_t, kMaxBands> fft_size{256, 256, 512};
+        size_t overlap = 4;
+        qwqdsp_window::Shape window = qwqdsp_window::Shape::kHann;
+
+        bool operator==(Config const&) const = default;
+    };
+
+    void Init(float fs, size_t num_channels) {
+        Init(fs, num_channels, Config{});
+    }
+
+    /**
+     * @brief carves the buffers of every band from one arena, call it from prepare
+     * @param num_channels at most SpectralPhaser::kMaxChannels, every channel gets the same masks
+     * @note with the channels and config of the last call nothing is carved again, it only does what
+     *       SetSampleRate() does
+     */
+    void Init(float fs, size_t num_channels, Config const& config) {
+        size_t const channels = std::clamp(num_channels, size_t{1}, SpectralPhaser::kMaxChannels);
+        if (arena_.GetSize() == 0 || channels != num_channels_ || config != config_) {
+            num_channels_ = channels;
+            config_ = config;
+            Layout();
+        }
+        SetSampleRate(fs);
+    }
+
+    /**
+     * @brief a new sample rate for the bands of Init(), does not allocate
+     * @note everything in flight is cleared like Reset()
+     */
+    void SetSampleRate(float fs) noexcept {
+        fs_ = fs;
+        float band_fs = fs;
+        for (size_t b = 0; b < num_bands_; ++b) {
+            bands_[b].fs = band_fs;
+            band_fs /= static_cast<float>(kDecimation);
+        }
+        for (auto& layer : layers_) {
+            layer.UpdateSpace(fs_, static_cast<float>(SpectralPhaser::kReferenceFftSize));
+        }
+        Reset();
+    }
+
+    /**
+     * @brief clears the audio in flight, only the part of the rings the bands use
+     */
+    void Reset() noexcept {
+        for (size_t b = 0; b < num_bands_; ++b) {
+            bands_[b].segement.Reset();
+        }
+        for (size_t b = 0; b + 1 < num_bands_; ++b) {
+            auto& s = splits_[b];
+            for (size_t ch = 0; ch < num_channels_; ++ch) {
+                s.decimate[ch].Reset();
+                s.reconstruct[ch].Reset();
+                s.upsample[ch].Reset();
+                s.input_delay[ch].Reset();
+                s.band_delay[ch].Reset();
+                s.low_delay[ch].Reset();
+            }
+        }
+    }
+
+    size_t GetLatency() const noexcept {
+        return latency_[0];
+    }
+
+    size_t GetNumChannels() const noexcept {
+        return num_channels_;
+    }
+
+    /**
+     * @brief where the memory of this instance is, the band split filters keep small buffers of their own that
+     *        are not counted
+     */
+    qwqdsp_memory::Footprint GetFootprint() const noexcept {
+        return {
+            .object_bytes = sizeof(*this),
+            .arena_bytes = arena_.GetSize(),
+            .num_buffers = arena_.GetNumPieces(),
+            .num_ffts = num_bands_,
+        };
+    }
+
+    void Update() noexcept {
+        for (auto& layer : layers_) {
+            layer.Update(fs_, static_cast<float>(SpectralPhaser::kReferenceFftSize),
+                         static_cast<float>(bands_[0].hop_size));
+        }
+    }
+
+    /**
+     * @param channels GetNumChannels() pointers
+     */
+    void Process(std::span<float* const> channels, size_t num_samples) noexcept {
+        PullParameters();
+        bool const idle = !phasy &&
+                          std::none_of(layers_.begin(), layers_.end(), [](auto const& l) { return l.enable; });
+        ProcessBlocks(channels, num_samples, idle);
+    }
+
+    /**
+     * @brief sounds like every layer disabled, the band filters still run so the latency stays the same
+     */
+    void ProcessBypassed(std::span<float* const> channels, size_t num_samples) noexcept {
+        ProcessBlocks(channels, num_samples, true);
+    }
+
+    SpectralPhaserLayer& GetLayer(size_t i) noexcept {
+        return layers_[i];
+    }
+
+    /**
+     * @param params like SpectralPhaser::SetParameters(), copied once per block
+     */
+    void SetParameters(SharedParameters const* params) noexcept {
+        params_ = params;
+        params_seen_ = 0;
+    }
+
+    bool phasy{};
+    PhasyType phasy_type{PhasyType::kPhase};
+    // glide time of the random gains in seconds
+    float phasy_smooth{};
+private:
+    struct Band {
+        qwqdsp_segement::AnalyzeSynthsisOnline segement;
+        audiofft::AudioFFT fft;
+        SpectralMask mask;
+        size_t fft_size{};
+        size_t hop_size{};
+        std::span<float const> analyze_window;
+        // carved from arena_
+        std::span<float> synthsis_window;
+        std::span<float> re;
+        std::span<float> im;
+        SpectralPhasy phasy;
+        float fs{};
+    };
+
+    // between band b and b + 1, one filter per channel
+    struct Split {
+        std::vector<qwqdsp_multirate::Decimator> decimate;
+        // the unprocessed lower band, removed from this band
+        std::vector<qwqdsp_multirate::Interpolator> reconstruct;
+        // the processed lower bands, added back
+        std::vector<qwqdsp_multirate::Interpolator> upsample;
+        std::vector<qwqdsp_multirate::Delay> input_delay;
+        std::vector<qwqdsp_multirate::Delay> band_delay;
+        std::vector<qwqdsp_multirate::Delay> low_delay;
+        // kBlockSize per channel, one channel after another
+        std::vector<float> low;
+        std::vector<float*> low_channels;
+        std::vector<float> tmp;
+    };
+
+    struct Filters {
+        std::array<float, kFilterSize> split{};
+        std::array<float, kFilterSize> image{};
+    };
+
+    // designed by the first Init() of the process, every instance runs the same filters
+    static Filters const& GetFilters() noexcept {
+        static Filters const filters = [] {
+            Filters f;
+            // the lower band is cut at fs / (4 * kDecimation) so nothing aliases when decimated, the
+            // reconstruction passes everything below that and removes the images
+            qwqdsp_multirate::DesignLowpass(f.split, 1.0f / (4.0f * kDecimation));
+            qwqdsp_multirate::DesignLowpass(f.image, 1.0f / (2.0f * kDecimation));
+            return f;
+        }();
+        return filters;
+    }
+
+    // the bands, filters and delays of config_, not realtime safe
+    void Layout() {
+        num_bands_ = std::clamp(config_.num_bands, size_t{1}, kMaxBands);
+        size_t const overlap = std::clamp(std::bit_ceil(config_.overlap), size_t{2}, SpectralPhaser::kMaxOverlap);
+
+        for (size_t b = 0; b < num_bands_; ++b) {
+            auto& band = bands_[b];
+            band.fft_size = std::bit_ceil(
+                std::clamp(config_.fft_size[b], SpectralPhaser::kMinFftSize, SpectralPhaser::kMaxFftSize));
+            band.hop_size = band.fft_size / overlap;
+        }
+        arena_.Carve([this](qwqdsp_memory::Arena& arena) {
+            for (size_t b = 0; b < num_bands_; ++b) {
+                auto& band = bands_[b];
+                size_t const num_bins = band.fft_size / 2 + 1;
+                band.segement.Carve(arena, num_channels_, band.fft_size, band.hop_size);
+                band.mask.Carve(arena, num_bins);
+                band.phasy.Carve(arena, num_bins);
+                band.synthsis_window = arena.Take<float>(band.fft_size);
+                band.re = arena.Take<float>(qwqdsp_simd::PadSize(band.fft_size));
+                band.im = arena.Take<float>(qwqdsp_simd::PadSize(band.fft_size));
+            }
+        });
+
+        // fs / kDecimation^b, relative to the full sample rate
+        float band_rate = 1.0f;
+        for (size_t b = 0; b < num_bands_; ++b) {
+            auto& band = bands_[b];
+            size_t const fft_size = band.fft_size;
+            size_t const hop_size = band.hop_size;
+
+            band.analyze_window = SpectralPhaser::BuildWindows(config_.window, band.synthsis_window, hop_size);
+            band.segement.SetSize(fft_size);
+            band.segement.SetHop(hop_size);
+            band.segement.SetWindow(band.analyze_window, band.synthsis_window);
+
+            band.fft.init(fft_size);
+            // the layers place their notches in reference bins at the full sample rate
+            band.mask.Prepare(fft_size / 2 + 1, static_cast<float>(SpectralPhaser::kReferenceFftSize) * band_rate /
+                                                    static_cast<float>(fft_size));
+
+            band.phasy.Seed(NextPhasySeed());
+            band.phasy.Prepare(fft_size / 2 + 1);
+            band_rate /= static_cast<float>(kDecimation);
+        }
+
+        auto const& filters = GetFilters();
+        // latency of a band includes everything below it, in samples of its own rate
+        latency_[num_bands_ - 1] = bands_[num_bands_ - 1].segement.GetLatency();
+        for (size_t b = num_bands_ - 1; b-- > 0;) {
+            auto& s = splits_[b];
+            // decimate + reconstruct, both linear phase
+            size_t const filter_latency = kFilterSize - 1;
+            size_t const band_latency = filter_latency + bands_[b].segement.GetLatency();
+            size_t const low_latency = filter_latency + kDecimation * latency_[b + 1];
+            latency_[b] = std::max(band_latency, low_latency);
+
+            s.decimate.resize(num_channels_);
+            s.reconstruct.resize(num_channels_);
+            s.upsample.resize(num_channels_);
+            s.input_delay.resize(num_channels_);
+            s.band_delay.resize(num_channels_);
+            s.low_delay.resize(num_channels_);
+            s.low.resize(num_channels_ * kBlockSize);
+            s.tmp.resize(kBlockSize);
+            s.low_channels.resize(num_channels_);
+            for (size_t ch = 0; ch < num_channels_; ++ch) {
+                s.low_channels[ch] = s.low.data() + ch * kBlockSize;
+                s.decimate[ch].Init(filters.split, kDecimation);
+                s.reconstruct[ch].Init(filters.image, kDecimation);
+                s.upsample[ch].Init(filters.image, kDecimation);
+                s.input_delay[ch].Init(filter_latency);
+                s.band_delay[ch].Init(latency_[b] - band_latency);
+                s.low_delay[ch].Init(latency_[b] - low_latency);
+            }
+        }
+    }
+
+    void PullParameters() noexcept {
+        if (params_ == nullptr || !params_->Load(param_block_, params_seen_)) return;
+        param_block_.ApplyTo(layers_);
+        phasy = param_block_.phasy;
+        phasy_type = param_block_.phasy_type;
+        phasy_smooth = param_block_.phasy_smooth;
+        for (auto& layer : layers_) {
+            layer.UpdateSpace(fs_, static_cast<float>(SpectralPhaser::kReferenceFftSize));
+        }
+    }
+
+    void ProcessBlocks(std::span<float* const> channels, size_t num_samples, bool passthrough) noexcept {
+        std::array<float*, SpectralPhaser::kMaxChannels> block{};
+        for (size_t offset = 0; offset < num_samples; offset += kBlockSize) {
+            size_t const n = std::min(num_samples - offset, kBlockSize);
+            for (size_t ch = 0; ch < num_channels_; ++ch) {
+                block[ch] = channels[ch] + offset;
+            }
+            ProcessBand(0, {block.data(), num_channels_}, n, passthrough);
+        }
+    }
+
+    void ProcessBand(size_t b, std::span<float* const> io, size_t num_samples, bool passthrough) noexcept {
+        if (b + 1 == num_bands_) {
+            ProcessStft(bands_[b], io, num_samples, passthrough);
+            return;
+        }
+
+        auto& s = splits_[b];
+        float* tmp = s.tmp.data();
+        size_t num_low = 0;
+        for (size_t ch = 0; ch < num_channels_; ++ch) {
+            num_low = s.decimate[ch].Process(io[ch], s.low_channels[ch], num_samples);
+            s.reconstruct[ch].Process(s.low_channels[ch], tmp, num_samples);
+            s.input_delay[ch].Process(io[ch], num_samples);
+            for (size_t i = 0; i < num_samples; ++i) {
+                io[ch][i] -= tmp[i];
+            }
+        }
+
+        ProcessStft(bands_[b], io, num_samples, passthrough);
+        ProcessBand(b + 1, s.low_channels, num_low, passthrough);
+
+        for (size_t ch = 0; ch < num_channels_; ++ch) {
+            s.upsample[ch].Process(s.low_channels[ch], tmp, num_samples);
+            s.band_delay[ch].Process(io[ch], num_samples);
+            s.low_delay[ch].Process(tmp, num_samples);
+            for (size_t i = 0; i < num_samples; ++i) {
+                io[ch][i] += tmp[i];
+            }
+        }
+    }
+
+    // same shortcuts as SpectralPhaser
+    void ProcessStft(Band& band, std::span<float* const> io, size_t num_samples, bool passthrough) noexcept {
+        if (passthrough) {
+            band.segement.ProcessPassthrough(io, num_samples);
+            return;
+        }
+
+        band.segement.Process(io, num_samples,
+                              [this, &band](std::span<float const* const> in, std::span<float* const> out) noexcept {
+                                  band.mask.Update(layers_);
+                                  if (phasy) {
+                                      band.phasy.Update(phasy_type,
+                                                        PhasyGlide(phasy_smooth, static_cast<float>(band.hop_size),
+                                                                   band.fs));
+                                  }
+                                  auto const& segement = band.segement;
+                                  size_t const size = band.fft_size;
+                                  size_t ch = 0;
+                                  for (; ch + 1 < in.size(); ch += 2) {
+                                      if (segement.IsFrameSilent(ch) && segement.IsFrameSilent(ch + 1)) continue;
+                                      if (std::memcmp(in[ch], in[ch + 1], size * sizeof(float)) == 0) {
+                                          band.fft.fft(in[ch], band.re.data(), band.im.data());
+                                          SpectralProcess(band);
+                                          band.fft.ifft(out[ch], band.re.data(), band.im.data());
+                                          std::copy_n(out[ch], size, out[ch + 1]);
+                                          continue;
+                                      }
+                                      band.fft.cfft(in[ch], in[ch + 1], band.re.data(), band.im.data());
+                                      SpectralProcessPacked(band);
+                                      band.fft.cifft(out[ch], out[ch + 1], band.re.data(), band.im.data());
+                                  }
+                                  for (; ch < in.size(); ++ch) {
+                                      if (segement.IsFrameSilent(ch)) continue;
+                                      band.fft.fft(in[ch], band.re.data(), band.im.data());
+                                      SpectralProcess(band);
+                                      band.fft.ifft(out[ch], band.re.data(), band.im.data());
+                                  }
+                              });
+    }
+
+    // same as SpectralPhaser::SpectralProcess()
+    void SpectralProcess(Band& band) noexcept {
+        band.mask.Apply(band.re.data(), band.im.data());
+        if (phasy) {
+            band.phasy.Apply(band.re.data(), band.im.data());
+        }
+    }
+
+    // same as SpectralPhaser::SpectralProcessPacked()
+    void SpectralProcessPacked(Band& band) noexcept {
+        band.mask.ApplyMirrored(band.re.data(), band.im.data());
+        if (phasy) {
+            band.phasy.ApplyMirrored(band.re.data(), band.im.data());
+        }
+    }
+
+    float fs_{};
+    size_t num_channels_{2};
+    size_t num_bands_{1};
+    Config config_;
+    std::array<SpectralPhaserLayer, kNumLayers> layers_;
+    SharedParameters const* params_{};
+    ParameterBlock param_block_;
+    uint32_t params_seen_{};
+    std::array<Band, kMaxBands> bands_;
+    std::array<Split, kMaxBands - 1> splits_;
+    std::array<size_t, kMaxBands> latency_{};
+    // the buffers of every band
+    qwqdsp_memory::Arena arena_;
+};
+
+} // namespace phaser
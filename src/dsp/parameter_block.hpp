@@ -0,0 +1,167 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "spectral_mask.hpp"
+#include "spectral_phasy.hpp"
+#include "worker_pool.hpp"
+
+namespace phaser {
+
+enum class LayerParam : size_t {
+    kEnable,
+    kPitch,
+    kMorph,
+    kPhase,
+    kDrywet,
+    kNumParams
+};
+
+/**
+ * @brief the user parameters of every layer, one array per parameter
+ */
+struct ParameterBlock {
+    static constexpr size_t kNumLayers = SpectralMask::kNumLayers;
+    static constexpr size_t kNumParams = static_cast<size_t>(LayerParam::kNumParams);
+
+    std::array<std::array<float, kNumLayers>, kNumParams> layers{};
+    bool phasy{};
+    PhasyType phasy_type{};
+    float phasy_smooth{};
+
+    float Get(LayerParam p, size_t layer) const noexcept {
+        return layers[static_cast<size_t>(p)][layer];
+    }
+
+    void ApplyTo(std::span<SpectralPhaserLayer, kNumLayers> dst) const noexcept {
+        for (size_t i = 0; i < kNumLayers; ++i) {
+            dst[i].enable = Get(LayerParam::kEnable, i) > 0.5f;
+            dst[i].pitch = Get(LayerParam::kPitch, i);
+            dst[i].morph = Get(LayerParam::kMorph, i);
+            dst[i].phase = Get(LayerParam::kPhase, i);
+            dst[i].drywet = Get(LayerParam::kDrywet, i);
+        }
+    }
+};
+
+/**
+ * @brief a ParameterBlock the parameter callbacks write, the audio thread copies it once per hop
+ * @note a seqlock. a write makes the version odd, stores and makes it even again, writers on two threads
+ *       take turns. a copy is only kept if the version was even and did not move while copying, so it
+ *       never mixes two writes. Hold() keeps readers on their last copy across many writes
+ */
+class SharedParameters {
+public:
+    static constexpr size_t kNumLayers = ParameterBlock::kNumLayers;
+    static constexpr size_t kNumParams = ParameterBlock::kNumParams;
+    // copies a Load() tries before it keeps the old block until the next hop
+    static constexpr size_t kMaxRetries = 4;
+
+    void Set(LayerParam p, size_t layer, float v) noexcept {
+        uint32_t const version = BeginWrite();
+        values_[static_cast<size_t>(p)][layer].store(v, std::memory_order_relaxed);
+        EndWrite(version);
+    }
+
+    void SetPhasy(bool v) noexcept {
+        uint32_t const version = BeginWrite();
+        phasy_.store(v, std::memory_order_relaxed);
+        EndWrite(version);
+    }
+
+    /**
+     * @param smooth glide time of the random gains in seconds
+     */
+    void SetPhasyType(PhasyType type, float smooth) noexcept {
+        uint32_t const version = BeginWrite();
+        phasy_type_.store(type, std::memory_order_relaxed);
+        phasy_smooth_.store(smooth, std::memory_order_relaxed);
+        EndWrite(version);
+    }
+
+    /**
+     * @brief readers keep their last copy until Release(), the writes in between land as a whole
+     */
+    void Hold() noexcept {
+        holds_.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    void Release() noexcept {
+        holds_.fetch_sub(1, std::memory_order_release);
+    }
+
+    /**
+     * @param seen version of the last copy, 0 before the first one
+     * @return true if anything was written since seen, block holds every value then. false leaves block as
+     *         it was
+     */
+    bool Load(ParameterBlock& block, uint32_t& seen) const noexcept {
+        for (size_t i = 0; i < kMaxRetries; ++i) {
+            if (holds_.load(std::memory_order_acquire) != 0) return false;
+            uint32_t const version = version_.load(std::memory_order_acquire);
+            if (version == seen) return false;
+            if ((version & 1) != 0) {
+                qwqdsp_parallel::CpuPause();
+                continue;
+            }
+
+            ParameterBlock copy;
+            for (size_t p = 0; p < kNumParams; ++p) {
+                for (size_t l = 0; l < kNumLayers; ++l) {
+                    copy.layers[p][l] = values_[p][l].load(std::memory_order_relaxed);
+                }
+            }
+            copy.phasy = phasy_.load(std::memory_order_relaxed);
+            copy.phasy_type = phasy_type_.load(std::memory_order_relaxed);
+            copy.phasy_smooth = phasy_smooth_.load(std::memory_order_relaxed);
+
+            // the loads above can not move below these. a Hold() that came before a write this copy holds is seen
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (holds_.load(std::memory_order_relaxed) != 0) return false;
+            if (version_.load(std::memory_order_relaxed) == version) {
+                block = copy;
+                seen = version;
+                return true;
+            }
+        }
+        return false;
+    }
+private:
+    // odd while a write is going on, returns the even version it started from
+    uint32_t BeginWrite() noexcept {
+        uint32_t version = version_.load(std::memory_order_relaxed);
+        for (;;) {
+            if ((version & 1) != 0) {
+                qwqdsp_parallel::CpuPause();
+                version = version_.load(std::memory_order_relaxed);
+            }
+            else if (version_.compare_exchange_weak(version, version + 1, std::memory_order_acquire,
+                                                    std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        // the stores after this can not move above the odd version
+        std::atomic_thread_fence(std::memory_order_release);
+        return version;
+    }
+
+    void EndWrite(uint32_t version) noexcept {
+        // skips 0, which a reader takes for never copied
+        uint32_t next = version + 2;
+        if (next == 0) next = 2;
+        version_.store(next, std::memory_order_release);
+    }
+
+    std::array<std::array<std::atomic<float>, kNumLayers>, kNumParams> values_{};
+    std::atomic<bool> phasy_{};
+    std::atomic<PhasyType> phasy_type_{};
+    std::atomic<float> phasy_smooth_{};
+    // even and above 0 so the first Load() always copies, odd during a write
+    std::atomic<uint32_t> version_{2};
+    std::atomic<uint32_t> holds_{};
+};
+
+} // namespace phaser
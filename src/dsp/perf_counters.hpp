@@ -0,0 +1,163 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace qwqdsp_perf {
+
+/**
+ * @brief time stamp counter, or nanoseconds where there is none
+ * @note the rate is not known here, the reader compares it with a clock
+ */
+inline uint64_t ReadCycles() noexcept {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t t;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(t));
+    return t;
+#else
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+#endif
+}
+
+/**
+ * @brief cycle counts in log spaced buckets, kBucketsPerOctave per octave
+ * @note only one thread may Record(), any other thread may Read() at the same time without locks.
+ *       the fields of a snapshot can be a record apart, fine for statistics
+ */
+class CycleHistogram {
+public:
+    static constexpr size_t kBucketsPerOctave = 4;
+    static constexpr size_t kNumBuckets = 40 * kBucketsPerOctave;
+
+    struct Snapshot {
+        std::array<uint32_t, kNumBuckets> counts{};
+        uint64_t count{};
+        uint64_t sum{};
+        // largest record since the Read() before this one
+        uint64_t max{};
+
+        /**
+         * @return the records after old, max stays the one of this snapshot
+         */
+        Snapshot Since(Snapshot const& old) const noexcept {
+            Snapshot r = *this;
+            for (size_t i = 0; i < kNumBuckets; ++i) {
+                r.counts[i] -= old.counts[i];
+            }
+            r.count -= old.count;
+            r.sum -= old.sum;
+            return r;
+        }
+
+        double Mean() const noexcept {
+            return count == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(count);
+        }
+
+        /**
+         * @return upper edge of the bucket the quantile falls in, at most 19% too high
+         */
+        uint64_t Quantile(double q) const noexcept {
+            uint64_t const target = static_cast<uint64_t>(q * static_cast<double>(count));
+            uint64_t acc = 0;
+            for (size_t i = 0; i < kNumBuckets; ++i) {
+                acc += counts[i];
+                if (acc > target) return std::min(UpperEdge(i), max);
+            }
+            return max;
+        }
+    };
+
+    // ---------------------------------------- writer ----------------------------------------
+
+    void Record(uint64_t cycles) noexcept {
+        // single writer, a load and a store is enough and much cheaper than a locked add
+        auto& bucket = counts_[BucketOf(cycles)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sum_.store(sum_.load(std::memory_order_relaxed) + cycles, std::memory_order_relaxed);
+        if (max_restart_.load(std::memory_order_relaxed) && max_restart_.exchange(false)) {
+            max_.store(0, std::memory_order_relaxed);
+        }
+        if (cycles > max_.load(std::memory_order_relaxed)) {
+            max_.store(cycles, std::memory_order_relaxed);
+        }
+        count_.store(count_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // ---------------------------------------- reader ----------------------------------------
+
+    /**
+     * @brief also starts a new window for Snapshot::max
+     */
+    Snapshot Read() noexcept {
+        Snapshot s;
+        s.count = count_.load(std::memory_order_acquire);
+        for (size_t i = 0; i < kNumBuckets; ++i) {
+            s.counts[i] = counts_[i].load(std::memory_order_relaxed);
+        }
+        s.sum = sum_.load(std::memory_order_relaxed);
+        s.max = max_.load(std::memory_order_relaxed);
+        max_restart_.store(true, std::memory_order_relaxed);
+        return s;
+    }
+
+    static size_t BucketOf(uint64_t cycles) noexcept {
+        if (cycles < 2) return 0;
+        size_t const octave = static_cast<size_t>(std::bit_width(cycles)) - 1;
+        // the two bits below the leading one pick the bucket in the octave
+        size_t const sub = octave >= 2 ? static_cast<size_t>(cycles >> (octave - 2)) & 3 : 0;
+        return std::min(octave * kBucketsPerOctave + sub, kNumBuckets - 1);
+    }
+
+    static uint64_t UpperEdge(size_t bucket) noexcept {
+        size_t const octave = bucket / kBucketsPerOctave;
+        uint64_t const sub = bucket % kBucketsPerOctave;
+        if (octave < 2) return (uint64_t{2} << octave) - 1;
+        return ((uint64_t{4} + sub + 1) << (octave - 2)) - 1;
+    }
+private:
+    std::array<std::atomic<uint32_t>, kNumBuckets> counts_{};
+    std::atomic<uint64_t> count_{};
+    std::atomic<uint64_t> sum_{};
+    std::atomic<uint64_t> max_{};
+    std::atomic<bool> max_restart_{};
+};
+
+/**
+ * @brief what one instance spends per callback and per hop, written by the audio thread only
+ */
+struct PerfCounters {
+    // a whole processBlock
+    CycleHistogram callback;
+    // the spectral work of a hop, the worker threads included
+    CycleHistogram hop;
+    // the parts of hop, summed over every hop and every thread
+    std::atomic<uint64_t> fft_cycles{};
+    std::atomic<uint64_t> spectral_cycles{};
+    std::atomic<uint64_t> num_samples{};
+    // bins of the sparse hops and the part of them the mask skipped
+    std::atomic<uint64_t> sparse_bins{};
+    std::atomic<uint64_t> skipped_bins{};
+
+    // the audio thread is the only writer
+    static void Add(std::atomic<uint64_t>& counter, uint64_t x) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + x, std::memory_order_relaxed);
+    }
+};
+
+} // namespace qwqdsp_perf
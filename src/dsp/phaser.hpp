@@ -1,142 +1,282 @@
 #pragma once
+#include <algorithm>
 #include <array>
-#include <complex>
-#include <random>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <utility>
 
 #include "AudioFFT.h"
 #include "analyze_synthsis_online.hpp"
-#include "hann.hpp"
+#include "arena.hpp"
+#include "parameter_block.hpp"
+#include "perf_counters.hpp"
+#include "spectral_mask.hpp"
+#include "spectral_phasy.hpp"
+#include "spectrum_analyzer.hpp"
+#include "window_table.hpp"
+#include "worker_pool.hpp"
 
 namespace phaser {
 
-class SpectralPhaserLayer {
+/**
+ * @brief optional worker threads for the per channel fft work of a hop
+ */
+struct ParallelConfig {
+    // besides the audio thread, 0 keeps everything on the audio thread
+    size_t num_workers = 0;
+    // the workers only take part from this many channels on, or from this fft size on
+    size_t min_channels = 8;
+    size_t min_fft_size = 4096;
+};
+
+class SpectralPhaser {
 public:
-    void ProcessFft(float* re, float* im, size_t num_bins) noexcept {
-        if (!enable) return;
+    static constexpr size_t kMinFftSize = 256;
+    static constexpr size_t kMaxFftSize = 8192;
+    static_assert(kMinFftSize >= qwqdsp_window::kMinTableSize && kMaxFftSize <= qwqdsp_window::kMaxTableSize);
+    static constexpr size_t kNumFftSizes = std::countr_zero(kMaxFftSize / kMinFftSize) + 1;
+    static constexpr size_t kMaxNumBins = kMaxFftSize / 2 + 1;
+    static constexpr size_t kMaxNumBinsPadded = qwqdsp_simd::PadSize(kMaxNumBins);
+    static constexpr size_t kMaxOverlap = 8;
+    // third order ambisonics
+    static constexpr size_t kMaxChannels = 16;
+    static constexpr size_t kNumLayers = SpectralMask::kNumLayers;
+    // layers place their notches in bins of this fft size, so the sound does not move when the mode changes
+    static constexpr size_t kReferenceFftSize = 1024;
+    // auto scaled sizes are relative to this sample rate
+    static constexpr float kReferenceFs = 48000.0f;
+
+    struct Mode {
+        size_t fft_size = 1024;
+        size_t overlap = 4;
+        // double the fft size every time the sample rate doubles
+        bool scale_with_fs = false;
+        qwqdsp_window::Shape window = qwqdsp_window::Shape::kHann;
+
+        bool operator==(Mode const&) const = default;
+    };
+
+    /**
+     * @brief leaves the quiet part of every hop dry, the mask is neither evaluated nor multiplied there
+     * @note decided per band of SpectralMask::kBandSize bins, the loudest channel of a band counts. phasy
+     *       still runs on every bin
+     */
+    struct Sparse {
+        bool enable = false;
+        // bands this far below the loudest band of the hop are skipped, in dB of power
+        float threshold_db = -60.0f;
+        // bands outside [min_freq, max_freq] are skipped, widened to whole bands. infinity leaves it open at the top
+        float min_freq = 0.0f;
+        float max_freq = std::numeric_limits<float>::infinity();
+
+        bool operator==(Sparse const&) const = default;
+    };
+
+    SpectralPhaser()
+        : phasy_seed_(NextPhasySeed()) {}
+
+    /**
+     * @brief carves every buffer for the largest mode from one arena, SetMode() will not allocate after this
+     * @param num_channels at most kMaxChannels, every channel gets the same mask
+     * @param parallel starts or stops the worker threads, not realtime safe
+     * @note with the channels and workers of the last call nothing is carved again, it only does what
+     *       SetSampleRate() does
+     */
+    void Init(float fs, size_t num_channels, ParallelConfig const& parallel = {}) {
+        parallel_ = parallel;
+
+        pool_.Start(parallel.num_workers);
+        size_t const channels = std::clamp(num_channels, size_t{1}, kMaxChannels);
+        bool const new_lanes = num_lanes_ != pool_.GetNumSlots();
+        if (new_lanes) {
+            num_lanes_ = pool_.GetNumSlots();
+            lanes_ = std::make_unique<Lane[]>(num_lanes_);
+            for (size_t l = 0; l < num_lanes_; ++l) {
+                for (size_t i = 0; i < kNumFftSizes; ++i) {
+                    lanes_[l].ffts[i].init(kMinFftSize << i);
+                }
+            }
+        }
 
-        float dry = 1 - drywet;
-        float wet = drywet;
-        for (size_t i = 0; i < num_bins; ++i) {
-            float g = GetGain(i, phase, space_);
-            re[i] = dry * re[i] + wet * g * re[i];
-            im[i] = dry * im[i] + wet * g * im[i];
+        if (new_lanes || channels != segement_.GetNumChannels()) {
+            arena_.Carve([this, channels](qwqdsp_memory::Arena& arena) {
+                segement_.Carve(arena, channels, kMaxFftSize, kMaxFftSize / 2);
+                mask_.Carve(arena, kMaxNumBins);
+                phasy_.Carve(arena, kMaxNumBins);
+                synthsis_window_ = arena.Take<float>(kMaxFftSize);
+                for (size_t l = 0; l < num_lanes_; ++l) {
+                    auto& lane = lanes_[l];
+                    lane.re = arena.Take<float>(kMaxNumBinsPadded);
+                    lane.im = arena.Take<float>(kMaxNumBinsPadded);
+                    lane.packed_re = arena.Take<float>(kMaxFftSize);
+                    lane.packed_im = arena.Take<float>(kMaxFftSize);
+                }
+                // enough for every job whether packed or not
+                job_spectra_ = arena.Take<float>(
+                    std::max((channels + 1) / 2 * kPackedJobFloats, channels * kRealJobFloats));
+                job_energy_ = arena.Take<float>(channels * kEnergyStride);
+                active_ = arena.Take<uint8_t>(kMaxNumBands);
+            });
         }
+        // the same phases and gains every Init(), a render after prepare always sounds the same
+        phasy_.Seed(phasy_seed_);
+        SetSampleRate(fs);
     }
 
-    void Update(float fs, float fft_size, float hop_size) noexcept {
-        float freq = 440.0f * std::exp2((pitch - 69.0f) / 12.0f);
-        float bins = freq / fs * fft_size;
-        space_ = Warp(bins);
+    /**
+     * @brief a new sample rate for the buffers of Init(), does not allocate
+     * @note the mode is applied from scratch, the fft size may follow the sample rate. everything in flight
+     *       is cleared like Reset()
+     */
+    void SetSampleRate(float fs) noexcept {
+        fs_ = fs;
+        for (auto& layer : layers_) {
+            layer.UpdateSpace(fs_, static_cast<float>(kReferenceFftSize));
+        }
+        fft_size_ = 0;
+        ApplyMode();
+    }
 
-        barber_phase_ += barber_freq * hop_size / fs;
-        barber_phase_ -= std::floor(barber_phase_);
+    /**
+     * @brief where the memory of this instance is, the arena is sized by Init()
+     */
+    qwqdsp_memory::Footprint GetFootprint() const noexcept {
+        return {
+            .object_bytes = sizeof(*this) + num_lanes_ * sizeof(Lane),
+            .arena_bytes = arena_.GetSize(),
+            .num_buffers = arena_.GetNumPieces(),
+            .num_ffts = num_lanes_ * kNumFftSizes,
+        };
     }
 
-    float GetLfoPhase() const noexcept {
-        return barber_phase_;
+    /**
+     * @return true if the effective fft size or hop changed, the latency may be different now
+     */
+    bool SetMode(Mode const& mode) noexcept {
+        if (mode == mode_) return false;
+        mode_ = mode;
+        return ApplyMode();
     }
 
-    void SetLfoPhase(float p) noexcept {
-        barber_phase_ = p;
+    Mode const& GetMode() const noexcept {
+        return mode_;
     }
 
-    bool enable{};
-    float pitch{};
-    float morph{};
-    float phase{};
-    float drywet{};
-    float barber_freq{};
-private:
-    float Warp(float x) noexcept {
-        float lin = x;
-        float log = std::log(x + 1);
-        return std::lerp(lin, log, morph);
+    void SetSparse(Sparse const& sparse) noexcept {
+        if (sparse == sparse_) return;
+        sparse_ = sparse;
+        UpdateSparse();
     }
 
-    /**
-     * @brief poly sin approximate from reaktor, -110dB 3rd harmonic
-     * @note x from 0.5 is sin, 0 is cos
-     * @param x [0.0, 1.0]
-     */
-    static inline constexpr float SinReaktor(float x) noexcept {
-        x = 2 * std::abs(x - 0.5f) - 0.5f;
-        float const x2 = x * x;
-        float u = -0.540347434104161f * x2 + 2.535656174488765f;
-        u = u * x2 - 5.166512943349853f;
-        u = u * x2 + 3.141592653589793f;
-        return u * x;
+    Sparse const& GetSparse() const noexcept {
+        return sparse_;
     }
 
-    float GetGain(size_t i, float phi, float cycle) noexcept {
-        float flange_phase = Warp(static_cast<float>(i)) / cycle;
-        flange_phase += phi;
-        flange_phase += barber_phase_;
-        flange_phase -= std::floor(flange_phase);
-        return SinReaktor(flange_phase) * 0.5f + 0.5f;
+    size_t GetFftSize() const noexcept {
+        return fft_size_;
     }
 
-    float space_{};
-    float barber_phase_{};
-};
+    size_t GetHopSize() const noexcept {
+        return hop_size_;
+    }
 
-class SpectralPhaser {
-public:
-    static constexpr size_t kFftSize = 1024;
-    static constexpr size_t kNumBins = kFftSize / 2 + 1;
-    static constexpr size_t kHopSize = 256;
-    static constexpr size_t kNumLayers = 4;
+    size_t GetLatency() const noexcept {
+        return segement_.GetLatency();
+    }
 
-    SpectralPhaser() {
-        qwqdsp_window::Hann::Window(hann_window_, true);
+    size_t GetNumChannels() const noexcept {
+        return segement_.GetNumChannels();
+    }
 
-        std::random_device rd{};
-        std::mt19937 rng{rd()};
-        std::uniform_real_distribution<float> dist(0.0f, std::numbers::pi_v<float>);
-        for (size_t i = 0; i < kNumBins; ++i) {
-            random_phase_[i] = std::polar(1.0f, dist(rng));
+    /**
+     * @param channels GetNumChannels() pointers
+     */
+    void Process(std::span<float* const> channels, size_t num_samples) noexcept {
+        PullParameters();
+        if (IsIdle()) {
+            segement_.ProcessPassthrough(channels, num_samples);
+        }
+        else {
+            segement_.Process(channels, num_samples, *this);
         }
     }
 
-    void Init(float fs) {
-        fs_ = fs;
-
-        segement_.SetSize(kFftSize);
-        segement_.SetHop(kHopSize);
-        fft_.init(kFftSize);
+    /**
+     * @brief sounds like every layer disabled, the latency stays the same and switching to or from
+     *        Process() at any block does not click
+     */
+    void ProcessBypassed(std::span<float* const> channels, size_t num_samples) noexcept {
+        segement_.ProcessPassthrough(channels, num_samples);
     }
 
-    void Process(float* left, float* right, size_t num_samples) noexcept {
-        segement_.Process({left, num_samples}, {right, num_samples}, *this);
+    /**
+     * @return true if nothing is enabled, the frames only pass through the windows
+     */
+    bool IsIdle() const noexcept {
+        return !phasy && std::none_of(layers_.begin(), layers_.end(), [](auto const& l) { return l.enable; });
     }
 
     void Update() noexcept {
         for (auto& layer : layers_) {
-            layer.Update(fs_, static_cast<float>(kFftSize), kHopSize);
+            layer.Update(fs_, static_cast<float>(kReferenceFftSize), static_cast<float>(hop_size_));
         }
     }
 
-    void operator()(std::span<float const> in_left, std::span<float const> in_right, std::span<float> out_left,
-                    std::span<float> out_right) noexcept {
-        for (size_t i = 0; i < kFftSize; ++i) {
-            out_left[i] = in_left[i] * hann_window_[i];
-        }
-        for (size_t i = 0; i < kFftSize; ++i) {
-            out_right[i] = in_right[i] * hann_window_[i];
-        }
+    void operator()(std::span<float const* const> in, std::span<float* const> out) noexcept {
+        uint64_t const begin = perf_ != nullptr ? qwqdsp_perf::ReadCycles() : 0;
 
-        fft_.fft(out_left.data(), re_.data(), im_.data());
-        SpectralProcess();
-        fft_.ifft(out_left.data(), re_.data(), im_.data());
+        // once per hop, every channel only pays for its fft and the multiply
+        PullParameters();
+        if (phasy) {
+            phasy_.Update(phasy_type, PhasyGlide(phasy_smooth, static_cast<float>(hop_size_), fs_));
+        }
+        analyze_hop_ = analyzer_ != nullptr && analyzer_->IsWanted();
 
-        fft_.fft(out_right.data(), re_.data(), im_.data());
-        SpectralProcess();
-        fft_.ifft(out_right.data(), re_.data(), im_.data());
+        size_t const num_jobs = packed ? (in.size() + 1) / 2 : in.size();
+        // the mask is all one without a layer, there is nothing to skip
+        bool const sparse = sparse_.enable && std::any_of(layers_.begin(), layers_.end(), [](auto const& l) {
+            return l.enable;
+        });
+        if (sparse) {
+            // every spectrum has to be known before the mask can be gated, so the jobs run twice
+            RunJobs(num_jobs, [this, in](size_t j, size_t slot) noexcept { ForwardJob(lanes_[slot], in, j); });
+            size_t const skipped = GateBands(num_jobs);
+            mask_.Update(layers_, active_);
+            RunJobs(num_jobs, [this, out](size_t j, size_t slot) noexcept { InverseJob(lanes_[slot], out, j); });
+            if (perf_ != nullptr) {
+                qwqdsp_perf::PerfCounters::Add(perf_->sparse_bins, num_bins_);
+                qwqdsp_perf::PerfCounters::Add(perf_->skipped_bins, skipped);
+            }
+        }
+        else {
+            mask_.Update(layers_);
+            RunJobs(num_jobs, [this, in, out](size_t j, size_t slot) noexcept {
+                ProcessJob(lanes_[slot], in, out, j);
+            });
+        }
 
-        for (size_t i = 0; i < kFftSize; ++i) {
-            out_left[i] *= hann_window_[i];
+        if (perf_ != nullptr) {
+            // the lanes of the workers are safe to read once Run() returned
+            for (size_t l = 0; l < num_lanes_; ++l) {
+                qwqdsp_perf::PerfCounters::Add(perf_->fft_cycles, std::exchange(lanes_[l].fft_cycles, 0));
+                qwqdsp_perf::PerfCounters::Add(perf_->spectral_cycles, std::exchange(lanes_[l].spectral_cycles, 0));
+            }
+            perf_->hop.Record(qwqdsp_perf::ReadCycles() - begin);
         }
-        for (size_t i = 0; i < kFftSize; ++i) {
-            out_right[i] *= hann_window_[i];
+
+        if (analyze_hop_) {
+            // job 0 already wrote the magnitudes
+            auto& frame = analyzer_->frames.Back();
+            auto const mask = mask_.GetMask();
+            for (size_t p = 0; p < AnalyzerTap::kNumPoints; ++p) {
+                frame.mask[p] = *std::min_element(mask.data() + point_begin_[p], mask.data() + point_end_[p]);
+            }
+            frame.fs = fs_;
+            analyzer_->frames.Publish();
         }
     }
 
@@ -144,33 +284,506 @@ public:
         return layers_[i];
     }
 
+    /**
+     * @param params copied into the layers and phasy once per block and once per hop when it changed,
+     *               nullptr to set them through GetLayer() and phasy from the audio thread instead
+     */
+    void SetParameters(SharedParameters const* params) noexcept {
+        params_ = params;
+        params_seen_ = 0;
+    }
+
+    /**
+     * @param perf records every hop that reaches the ffts, nullptr turns the timing off
+     */
+    void SetPerfCounters(qwqdsp_perf::PerfCounters* perf) noexcept {
+        perf_ = perf;
+    }
+
+    /**
+     * @param analyzer gets a frame every hop that reaches the ffts while it has a view, nullptr for none
+     */
+    void SetAnalyzer(AnalyzerTap* analyzer) noexcept {
+        analyzer_ = analyzer;
+    }
+
+    /**
+     * @brief clears the audio in flight, only the part of the rings the current mode uses
+     */
+    void Reset() noexcept {
+        segement_.Reset();
+    }
+
+    /**
+     * @brief the analyze window is a table, the synthsis window is scaled so a hop of frames overlap adds to
+     *        exactly the input
+     * @return the analyze window
+     */
+    static std::span<float const> BuildWindows(qwqdsp_window::Shape shape, std::span<float> synthsis,
+                                               size_t hop_size) noexcept {
+        auto const analyze = qwqdsp_window::GetTable(shape, synthsis.size());
+        qwqdsp_window::BuildSynthsis(analyze, synthsis, hop_size);
+        return analyze;
+    }
+
     bool phasy{};
+    PhasyType phasy_type{PhasyType::kPhase};
+    // glide time of the random gains in seconds
+    float phasy_smooth{};
+    // two channels per complex fft, false: one real fft per channel, for A/B testing
+    bool packed{true};
 private:
-    void SpectralProcess() noexcept {
+    static constexpr size_t kMaxNumBands = kMaxNumBinsPadded / SpectralMask::kBandSize;
+    // the spectrum a job keeps between the halves of a sparse hop, re then im
+    static constexpr size_t kPackedJobFloats = 2 * kMaxFftSize;
+    static constexpr size_t kRealJobFloats = 2 * kMaxNumBinsPadded;
+    // band energies of a job, the jobs never share a line
+    static constexpr size_t kEnergyStride = qwqdsp_memory::PadToCacheLine(kMaxNumBands * sizeof(float)) / sizeof(float);
+
+    // what the transform of a job was, the spectrum is processed and turned back the same way
+    enum class JobKind : uint8_t {
+        // nothing to do, every channel of the job is silent
+        kSilent,
+        // the odd channel out, or every channel with packed off
+        kReal,
+        // mono on a stereo bus, one real fft is half the work of the packed one
+        kRealPair,
+        // a + j * b, the filter is hermitian so both channels stay separated
+        kPacked,
+    };
+
+    // everything one thread needs for the spectral work of a hop, the counters of two lanes never share a line
+    struct alignas(qwqdsp_memory::kCacheLine) Lane {
+        // one per supported size, switching mode must not allocate
+        std::array<audiofft::AudioFFT, kNumFftSizes> ffts;
+        // carved from arena_
+        std::span<float> re;
+        std::span<float> im;
+        std::span<float> packed_re;
+        std::span<float> packed_im;
+        // only counted with perf_ set, collected by the audio thread after every hop
+        uint64_t fft_cycles{};
+        uint64_t spectral_cycles{};
+    };
+
+    void PullParameters() noexcept {
+        if (params_ == nullptr || !params_->Load(param_block_, params_seen_)) return;
+        param_block_.ApplyTo(layers_);
+        phasy = param_block_.phasy;
+        phasy_type = param_block_.phasy_type;
+        phasy_smooth = param_block_.phasy_smooth;
         for (auto& layer : layers_) {
-            layer.ProcessFft(re_.data(), im_.data(), kNumBins);
+            layer.UpdateSpace(fs_, static_cast<float>(kReferenceFftSize));
         }
+    }
 
-        if (phasy) {
-            for (size_t i = 0; i < kNumBins; ++i) {
-                std::complex a{re_[i], im_[i]};
-                a *= random_phase_[i];
-                re_[i] = a.real();
-                im_[i] = a.imag();
+    bool UsePool() const noexcept {
+        return num_lanes_ > 1 &&
+               (GetNumChannels() >= parallel_.min_channels || fft_size_ >= parallel_.min_fft_size);
+    }
+
+    template <class Job>
+    void RunJobs(size_t num_jobs, Job&& job) noexcept {
+        if (UsePool()) {
+            // joined before the segementer overlap adds
+            pool_.Run(num_jobs, job);
+        }
+        else {
+            for (size_t j = 0; j < num_jobs; ++j) {
+                job(j, 0);
             }
         }
     }
 
+    JobKind GetJobKind(std::span<float const* const> in, size_t job) const noexcept {
+        size_t const ch = packed ? 2 * job : job;
+        bool const pair = packed && ch + 1 < in.size();
+        if (segement_.IsFrameSilent(ch) && (!pair || segement_.IsFrameSilent(ch + 1))) return JobKind::kSilent;
+        if (!pair) return JobKind::kReal;
+        if (std::memcmp(in[ch], in[ch + 1], fft_size_ * sizeof(float)) == 0) return JobKind::kRealPair;
+        return JobKind::kPacked;
+    }
+
+    void Forward(audiofft::AudioFFT& fft, JobKind kind, std::span<float const* const> in, size_t ch, float* re,
+                 float* im) const noexcept {
+        if (kind == JobKind::kPacked) {
+            fft.cfft(in[ch], in[ch + 1], re, im);
+        }
+        else {
+            fft.fft(in[ch], re, im);
+        }
+        if (analyze_hop_ && ch == 0) Analyze(re, im, kind == JobKind::kPacked);
+    }
+
+    void Spectral(JobKind kind, float* re, float* im) const noexcept {
+        if (kind == JobKind::kPacked) {
+            SpectralProcessPacked(re, im);
+        }
+        else {
+            SpectralProcess(re, im);
+        }
+    }
+
+    void Inverse(audiofft::AudioFFT& fft, JobKind kind, std::span<float* const> out, size_t ch, float* re,
+                 float* im) const noexcept {
+        if (kind == JobKind::kPacked) {
+            fft.cifft(out[ch], out[ch + 1], re, im);
+            return;
+        }
+        fft.ifft(out[ch], re, im);
+        if (kind == JobKind::kRealPair) std::copy_n(out[ch], fft_size_, out[ch + 1]);
+    }
+
+    void ProcessJob(Lane& lane, std::span<float const* const> in, std::span<float* const> out,
+                    size_t job) const noexcept {
+        auto& fft = lane.ffts[fft_index_];
+        size_t const ch = packed ? 2 * job : job;
+        JobKind const kind = GetJobKind(in, job);
+        if (kind == JobKind::kSilent) {
+            if (analyze_hop_ && job == 0) analyzer_->frames.Back().magnitude.fill(0.0f);
+            return;
+        }
+        float* re = kind == JobKind::kPacked ? lane.packed_re.data() : lane.re.data();
+        float* im = kind == JobKind::kPacked ? lane.packed_im.data() : lane.im.data();
+
+        // fft, spectral, ifft
+        std::array<uint64_t, 4> t{};
+        bool const timed = perf_ != nullptr;
+        if (timed) t[0] = qwqdsp_perf::ReadCycles();
+        Forward(fft, kind, in, ch, re, im);
+        if (timed) t[1] = qwqdsp_perf::ReadCycles();
+        Spectral(kind, re, im);
+        if (timed) t[2] = qwqdsp_perf::ReadCycles();
+        Inverse(fft, kind, out, ch, re, im);
+        if (timed) {
+            t[3] = qwqdsp_perf::ReadCycles();
+            lane.fft_cycles += (t[1] - t[0]) + (t[3] - t[2]);
+            lane.spectral_cycles += t[2] - t[1];
+        }
+    }
+
+    // re and im of a job between the halves of a sparse hop
+    std::pair<float*, float*> JobSpectrum(size_t job) const noexcept {
+        size_t const size = packed ? kPackedJobFloats : kRealJobFloats;
+        float* re = job_spectra_.data() + job * size;
+        return {re, re + size / 2};
+    }
+
+    /**
+     * @brief first half of a sparse hop, the fft and how much energy every band of the job has
+     */
+    void ForwardJob(Lane& lane, std::span<float const* const> in, size_t job) noexcept {
+        size_t const ch = packed ? 2 * job : job;
+        JobKind const kind = GetJobKind(in, job);
+        job_kinds_[job] = kind;
+        if (kind == JobKind::kSilent) {
+            if (analyze_hop_ && job == 0) analyzer_->frames.Back().magnitude.fill(0.0f);
+            return;
+        }
+        auto const [re, im] = JobSpectrum(job);
+
+        std::array<uint64_t, 3> t{};
+        bool const timed = perf_ != nullptr;
+        if (timed) t[0] = qwqdsp_perf::ReadCycles();
+        Forward(lane.ffts[fft_index_], kind, in, ch, re, im);
+        if (timed) t[1] = qwqdsp_perf::ReadCycles();
+
+        // per channel, a packed job keeps the louder of its two. the nyquist bin is the only one of the last
+        // band, the rest of it is padding
+        constexpr size_t kBand = SpectralMask::kBandSize;
+        float* energy = job_energy_.data() + job * kEnergyStride;
+        size_t const half = fft_size_ / 2;
+        if (kind != JobKind::kPacked) {
+            for (size_t k = 0; k < half; k += kBand) {
+                energy[k / kBand] = BandEnergy(re + k, im + k);
+            }
+            energy[half / kBand] = re[half] * re[half] + im[half] * im[half];
+        }
+        else {
+            // X[N-k] turned around into the lane, so it lines up with X[k]. X[0] is its own mirror
+            float* mirror_re = lane.re.data();
+            float* mirror_im = lane.im.data();
+            mirror_re[0] = re[0];
+            mirror_im[0] = im[0];
+            std::reverse_copy(re + half + 1, re + fft_size_, mirror_re + 1);
+            std::reverse_copy(im + half + 1, im + fft_size_, mirror_im + 1);
+            for (size_t k = 0; k < half; k += kBand) {
+                energy[k / kBand] = PackedBandEnergy(re + k, im + k, mirror_re + k, mirror_im + k);
+            }
+            energy[half / kBand] = std::max(re[half] * re[half], im[half] * im[half]);
+        }
+
+        if (timed) {
+            t[2] = qwqdsp_perf::ReadCycles();
+            lane.fft_cycles += t[1] - t[0];
+            lane.spectral_cycles += t[2] - t[1];
+        }
+    }
+
+    // |x|^2 summed over the kBandSize bins from re, im on
+    static float BandEnergy(float const* re, float const* im) noexcept {
+        using V = qwqdsp_simd::Native;
+        auto sum = V::Set(0.0f);
+        for (size_t j = 0; j < SpectralMask::kBandSize; j += V::kWidth) {
+            auto const a = V::Load(re + j);
+            auto const b = V::Load(im + j);
+            sum = V::MulAdd(a, a, V::MulAdd(b, b, sum));
+        }
+        return SumLanes(sum);
+    }
+
+    /**
+     * @brief BandEnergy() of a and b from the spectrum of a + j * b, the louder one
+     * @param mirror_re X[N-k] for every X[k] of re, im
+     */
+    static float PackedBandEnergy(float const* re, float const* im, float const* mirror_re,
+                                  float const* mirror_im) noexcept {
+        using V = qwqdsp_simd::Native;
+        // 2A = X[k] + conj(X[N-k]), 2jB = X[k] - conj(X[N-k])
+        auto sum_a = V::Set(0.0f);
+        auto sum_b = V::Set(0.0f);
+        for (size_t j = 0; j < SpectralMask::kBandSize; j += V::kWidth) {
+            auto const xr = V::Load(re + j);
+            auto const xi = V::Load(im + j);
+            auto const mr = V::Load(mirror_re + j);
+            auto const mi = V::Load(mirror_im + j);
+            auto const ar = V::Add(xr, mr);
+            auto const ai = V::Sub(xi, mi);
+            auto const br = V::Sub(xr, mr);
+            auto const bi = V::Add(xi, mi);
+            sum_a = V::MulAdd(ar, ar, V::MulAdd(ai, ai, sum_a));
+            sum_b = V::MulAdd(br, br, V::MulAdd(bi, bi, sum_b));
+        }
+        return 0.25f * std::max(SumLanes(sum_a), SumLanes(sum_b));
+    }
+
+    template <class Vec>
+    static float SumLanes(Vec v) noexcept {
+        using V = qwqdsp_simd::Native;
+        std::array<float, V::kWidth> lanes;
+        V::Store(lanes.data(), v);
+        float sum = 0.0f;
+        for (float x : lanes) {
+            sum += x;
+        }
+        return sum;
+    }
+
+    /**
+     * @brief second half of a sparse hop, after the mask was gated
+     */
+    void InverseJob(Lane& lane, std::span<float* const> out, size_t job) const noexcept {
+        JobKind const kind = job_kinds_[job];
+        if (kind == JobKind::kSilent) return;
+        size_t const ch = packed ? 2 * job : job;
+        auto const [re, im] = JobSpectrum(job);
+
+        std::array<uint64_t, 3> t{};
+        bool const timed = perf_ != nullptr;
+        if (timed) t[0] = qwqdsp_perf::ReadCycles();
+        Spectral(kind, re, im);
+        if (timed) t[1] = qwqdsp_perf::ReadCycles();
+        Inverse(lane.ffts[fft_index_], kind, out, ch, re, im);
+        if (timed) {
+            t[2] = qwqdsp_perf::ReadCycles();
+            lane.spectral_cycles += t[1] - t[0];
+            lane.fft_cycles += t[2] - t[1];
+        }
+    }
+
+    /**
+     * @brief the bands of this hop the mask works on, into active_
+     * @return bins left dry
+     */
+    size_t GateBands(size_t num_jobs) noexcept {
+        size_t const num_bands = qwqdsp_simd::PadSize(num_bins_) / SpectralMask::kBandSize;
+        float peak = 0.0f;
+        for (size_t b = 0; b < num_bands; ++b) {
+            float e = 0.0f;
+            for (size_t j = 0; j < num_jobs; ++j) {
+                if (job_kinds_[j] != JobKind::kSilent) e = std::max(e, job_energy_[j * kEnergyStride + b]);
+            }
+            // the first job keeps the loudest channel of every band
+            job_energy_[b] = e;
+            peak = std::max(peak, e);
+        }
+
+        float const floor = peak * sparse_threshold_;
+        size_t skipped = 0;
+        for (size_t b = 0; b < num_bands; ++b) {
+            bool const on = b >= sparse_begin_ && b < sparse_end_ && job_energy_[b] > floor;
+            active_[b] = on;
+            if (!on) {
+                size_t const begin = b * SpectralMask::kBandSize;
+                skipped += std::min(begin + SpectralMask::kBandSize, num_bins_) - begin;
+            }
+        }
+        return skipped;
+    }
+
+    // the threshold and band range of sparse_ for the current fft size
+    void UpdateSparse() noexcept {
+        sparse_threshold_ = std::pow(10.0f, sparse_.threshold_db / 10.0f);
+        if (fs_ <= 0.0f || fft_size_ == 0) return;
+        float const bands_per_hz =
+            static_cast<float>(fft_size_) / fs_ / static_cast<float>(SpectralMask::kBandSize);
+        size_t const num_bands = qwqdsp_simd::PadSize(num_bins_) / SpectralMask::kBandSize;
+        // clamped before the cast, an infinite max_freq is past every band
+        float const last = static_cast<float>(num_bands);
+        float const lo = std::min(std::floor(std::max(sparse_.min_freq, 0.0f) * bands_per_hz), last);
+        float const hi = std::min(std::floor(std::max(sparse_.max_freq, 0.0f) * bands_per_hz) + 1.0f, last);
+        sparse_begin_ = static_cast<size_t>(lo);
+        sparse_end_ = static_cast<size_t>(hi);
+    }
+
+    /**
+     * @brief peak magnitude of the bins under every point into the back frame of analyzer_
+     * @param two_channels re, im is the full spectrum of a + j * b, the rms of a and b is taken
+     */
+    void Analyze(float const* re, float const* im, bool two_channels) const noexcept {
+        auto& magnitude = analyzer_->frames.Back().magnitude;
+        float const scale = analyze_scale_;
+        for (size_t p = 0; p < AnalyzerTap::kNumPoints; ++p) {
+            float peak = 0.0f;
+            for (size_t k = point_begin_[p]; k < point_end_[p]; ++k) {
+                float power;
+                if (two_channels) {
+                    // 2A = X[k] + conj(X[N-k]), 2jB = X[k] - conj(X[N-k])
+                    size_t const nk = k == 0 ? 0 : fft_size_ - k;
+                    float const ar = re[k] + re[nk];
+                    float const ai = im[k] - im[nk];
+                    float const br = re[k] - re[nk];
+                    float const bi = im[k] + im[nk];
+                    power = (ar * ar + ai * ai + br * br + bi * bi) * 0.125f;
+                }
+                else {
+                    power = re[k] * re[k] + im[k] * im[k];
+                }
+                peak = std::max(peak, power);
+            }
+            magnitude[p] = std::sqrt(peak) * scale;
+        }
+    }
+
+    // bins under every analyzer point, edges halfway between the points on the log axis
+    void BuildPoints() noexcept {
+        // SetMode() before Init()
+        if (fs_ <= 0.0f) return;
+        float const bins_per_hz = static_cast<float>(fft_size_) / fs_;
+        for (size_t p = 0; p < AnalyzerTap::kNumPoints; ++p) {
+            float const i = static_cast<float>(p);
+            float const lo = std::round(AnalyzerTap::PointFreq(i - 0.5f, fs_) * bins_per_hz);
+            float const hi = std::round(AnalyzerTap::PointFreq(i + 0.5f, fs_) * bins_per_hz);
+            point_begin_[p] = std::min(static_cast<size_t>(lo), num_bins_ - 1);
+            point_end_[p] = std::clamp(static_cast<size_t>(hi), point_begin_[p] + 1, num_bins_);
+        }
+    }
+
+    bool ApplyMode() noexcept {
+        // SetMode() before Init(), Init() applies it
+        if (arena_.GetSize() == 0) return false;
+
+        size_t fft_size = std::bit_ceil(std::clamp(mode_.fft_size, kMinFftSize, kMaxFftSize));
+        if (mode_.scale_with_fs && fs_ > 0.0f) {
+            int const octave = static_cast<int>(std::round(std::log2(fs_ / kReferenceFs)));
+            fft_size = octave >= 0 ? fft_size << octave : fft_size >> -octave;
+            fft_size = std::clamp(fft_size, kMinFftSize, kMaxFftSize);
+        }
+        size_t const overlap = std::clamp(std::bit_ceil(mode_.overlap), size_t{2}, kMaxOverlap);
+        size_t const hop_size = fft_size / overlap;
+        bool const resized = fft_size != fft_size_ || hop_size != hop_size_;
+        if (!resized && mode_.window == window_) return false;
+
+        if (resized) {
+            fft_size_ = fft_size;
+            hop_size_ = hop_size;
+            num_bins_ = fft_size / 2 + 1;
+            fft_index_ = static_cast<size_t>(std::countr_zero(fft_size / kMinFftSize));
+            segement_.SetSize(fft_size);
+            segement_.SetHop(hop_size);
+            mask_.Prepare(num_bins_, static_cast<float>(kReferenceFftSize) / static_cast<float>(fft_size));
+            phasy_.Prepare(num_bins_);
+            BuildPoints();
+            UpdateSparse();
+        }
+
+        window_ = mode_.window;
+        auto const analyze = BuildWindows(window_, {synthsis_window_.data(), fft_size}, hop_size);
+        segement_.SetWindow(analyze, {synthsis_window_.data(), fft_size});
+        // a sine of amplitude 1 peaks at sum(window) / 2
+        float wsum = 0.0f;
+        for (float w : analyze) {
+            wsum += w;
+        }
+        analyze_scale_ = 2.0f / wsum;
+        return resized;
+    }
+
+    void SpectralProcess(float* re, float* im) const noexcept {
+        mask_.Apply(re, im);
+        if (phasy) {
+            phasy_.Apply(re, im);
+        }
+    }
+
+    /**
+     * @brief same filter as SpectralProcess() on the full spectrum of a + j * b
+     * @note X[N-k] gets conj of the gain of X[k], DC and nyquist only keep the real part
+     *       like the real ifft does
+     */
+    void SpectralProcessPacked(float* xr, float* xi) const noexcept {
+        mask_.ApplyMirrored(xr, xi);
+        if (phasy) {
+            phasy_.ApplyMirrored(xr, xi);
+        }
+    }
+
     float fs_{};
+    Mode mode_;
+    qwqdsp_window::Shape window_{};
+    size_t fft_size_{};
+    size_t hop_size_{};
+    size_t num_bins_{};
+
     std::array<SpectralPhaserLayer, kNumLayers> layers_;
+    SpectralMask mask_;
+    SpectralPhasy phasy_;
+    uint32_t phasy_seed_{};
+    SharedParameters const* params_{};
+    ParameterBlock param_block_;
+    uint32_t params_seen_{};
 
     qwqdsp_segement::AnalyzeSynthsisOnline segement_;
-    audiofft::AudioFFT fft_;
+    size_t fft_index_{};
+
+    ParallelConfig parallel_;
+    qwqdsp_parallel::WorkerPool pool_;
+    // lanes_[slot] belongs to the thread the pool runs a job on, 0 is the audio thread
+    std::unique_ptr<Lane[]> lanes_;
+    size_t num_lanes_{};
+    qwqdsp_perf::PerfCounters* perf_{};
+    AnalyzerTap* analyzer_{};
+    // set by the audio thread before the jobs of a hop run
+    bool analyze_hop_{};
+    std::array<size_t, AnalyzerTap::kNumPoints> point_begin_{};
+    std::array<size_t, AnalyzerTap::kNumPoints> point_end_{};
+
+    Sparse sparse_;
+    // power against the loudest band, from sparse_.threshold_db
+    float sparse_threshold_{1e-6f};
+    // bands [sparse_begin_, sparse_end_) may be processed
+    size_t sparse_begin_{};
+    size_t sparse_end_{};
+    std::array<JobKind, kMaxChannels> job_kinds_{};
 
-    std::array<float, kNumBins> re_;
-    std::array<float, kNumBins> im_;
-    std::array<float, kFftSize> hann_window_;
-    std::array<std::complex<float>, kNumBins> random_phase_;
+    std::span<float> synthsis_window_;
+    float analyze_scale_{};
+    // sparse hops only, the spectra and band energies of every job and the bands the mask works on
+    std::span<float> job_spectra_;
+    std::span<float> job_energy_;
+    std::span<uint8_t> active_;
+    // every buffer above that is sized by Init()
+    qwqdsp_memory::Arena arena_;
 };
 
 } // namespace phaser
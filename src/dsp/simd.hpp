@@ -0,0 +1,335 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define QWQDSP_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QWQDSP_SIMD_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define QWQDSP_SIMD_NEON
+#endif
+
+namespace qwqdsp_simd {
+
+// every buffer a kernel walks over is padded to this, so no kernel needs a scalar tail
+static constexpr size_t kMaxWidth = 16;
+
+static constexpr size_t PadSize(size_t n) noexcept {
+    return (n + kMaxWidth - 1) / kMaxWidth * kMaxWidth;
+}
+
+/**
+ * @brief cephes logf, x must be positive and normal
+ */
+template <class V>
+inline typename V::Float LogCephes(typename V::Float x) noexcept {
+    using F = typename V::Float;
+    F e;
+    x = V::Frexp(x, e);
+
+    F const less = V::LessMask(x, V::Set(0.707106781186547524f));
+    F const tmp = V::AndMask(less, x);
+    x = V::Sub(x, V::Set(1.0f));
+    e = V::Sub(e, V::AndMask(less, V::Set(1.0f)));
+    x = V::Add(x, tmp);
+
+    F const z = V::Mul(x, x);
+    F y = V::Set(7.0376836292E-2f);
+    y = V::MulAdd(y, x, V::Set(-1.1514610310E-1f));
+    y = V::MulAdd(y, x, V::Set(1.1676998740E-1f));
+    y = V::MulAdd(y, x, V::Set(-1.2420140846E-1f));
+    y = V::MulAdd(y, x, V::Set(1.4249322787E-1f));
+    y = V::MulAdd(y, x, V::Set(-1.6668057665E-1f));
+    y = V::MulAdd(y, x, V::Set(2.0000714765E-1f));
+    y = V::MulAdd(y, x, V::Set(-2.4999993993E-1f));
+    y = V::MulAdd(y, x, V::Set(3.3333331174E-1f));
+    y = V::Mul(V::Mul(y, x), z);
+
+    y = V::MulAdd(e, V::Set(-2.12194440e-4f), y);
+    y = V::MulAdd(z, V::Set(-0.5f), y);
+    x = V::Add(x, y);
+    return V::MulAdd(e, V::Set(0.693359375f), x);
+}
+
+struct Scalar {
+    using Float = float;
+    using Uint = uint32_t;
+    static constexpr size_t kWidth = 1;
+
+    static Float Load(float const* p) noexcept {
+        return *p;
+    }
+    static void Store(float* p, Float x) noexcept {
+        *p = x;
+    }
+    static Float Set(float x) noexcept {
+        return x;
+    }
+    static Float Add(Float a, Float b) noexcept {
+        return a + b;
+    }
+    static Float Sub(Float a, Float b) noexcept {
+        return a - b;
+    }
+    static Float Mul(Float a, Float b) noexcept {
+        return a * b;
+    }
+    // a * b + c
+    static Float MulAdd(Float a, Float b, Float c) noexcept {
+        return a * b + c;
+    }
+    static Float Floor(Float x) noexcept {
+        return std::floor(x);
+    }
+    static Float Abs(Float x) noexcept {
+        return std::abs(x);
+    }
+    static Float Log(Float x) noexcept {
+        return std::log(x);
+    }
+    static Uint LoadUint(uint32_t const* p) noexcept {
+        return *p;
+    }
+    static void StoreUint(uint32_t* p, Uint x) noexcept {
+        *p = x;
+    }
+    // one xorshift32 step, x must not be 0
+    static Uint XorShift(Uint x) noexcept {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return x;
+    }
+    // the high 23 bits as a float in [0, 1)
+    static Float ToUnit(Uint x) noexcept {
+        return static_cast<float>(x >> 9) * (1.0f / 8388608.0f);
+    }
+};
+
+#if defined(QWQDSP_SIMD_AVX2)
+struct Avx2 {
+    using Float = __m256;
+    using Uint = __m256i;
+    static constexpr size_t kWidth = 8;
+
+    static Float Load(float const* p) noexcept {
+        return _mm256_loadu_ps(p);
+    }
+    static void Store(float* p, Float x) noexcept {
+        _mm256_storeu_ps(p, x);
+    }
+    static Float Set(float x) noexcept {
+        return _mm256_set1_ps(x);
+    }
+    static Float Add(Float a, Float b) noexcept {
+        return _mm256_add_ps(a, b);
+    }
+    static Float Sub(Float a, Float b) noexcept {
+        return _mm256_sub_ps(a, b);
+    }
+    static Float Mul(Float a, Float b) noexcept {
+        return _mm256_mul_ps(a, b);
+    }
+    static Float MulAdd(Float a, Float b, Float c) noexcept {
+#ifdef __FMA__
+        return _mm256_fmadd_ps(a, b, c);
+#else
+        return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+    }
+    static Float Floor(Float x) noexcept {
+        return _mm256_floor_ps(x);
+    }
+    static Float Abs(Float x) noexcept {
+        return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x);
+    }
+    static Float LessMask(Float a, Float b) noexcept {
+        return _mm256_cmp_ps(a, b, _CMP_LT_OQ);
+    }
+    static Float AndMask(Float mask, Float x) noexcept {
+        return _mm256_and_ps(mask, x);
+    }
+    // mantissa in [0.5, 1)
+    static Float Frexp(Float x, Float& e) noexcept {
+        __m256i bits = _mm256_castps_si256(x);
+        e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+        bits = _mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff));
+        bits = _mm256_or_si256(bits, _mm256_set1_epi32(0x3f000000));
+        return _mm256_castsi256_ps(bits);
+    }
+    static Float Log(Float x) noexcept {
+        return LogCephes<Avx2>(x);
+    }
+    static Uint LoadUint(uint32_t const* p) noexcept {
+        return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+    }
+    static void StoreUint(uint32_t* p, Uint x) noexcept {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), x);
+    }
+    static Uint XorShift(Uint x) noexcept {
+        x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 13));
+        x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 17));
+        return _mm256_xor_si256(x, _mm256_slli_epi32(x, 5));
+    }
+    // 1.m - 1 with the high bits as mantissa
+    static Float ToUnit(Uint x) noexcept {
+        __m256i const bits = _mm256_or_si256(_mm256_srli_epi32(x, 9), _mm256_set1_epi32(0x3f800000));
+        return _mm256_sub_ps(_mm256_castsi256_ps(bits), _mm256_set1_ps(1.0f));
+    }
+};
+using Native = Avx2;
+#elif defined(QWQDSP_SIMD_SSE2)
+struct Sse2 {
+    using Float = __m128;
+    using Uint = __m128i;
+    static constexpr size_t kWidth = 4;
+
+    static Float Load(float const* p) noexcept {
+        return _mm_loadu_ps(p);
+    }
+    static void Store(float* p, Float x) noexcept {
+        _mm_storeu_ps(p, x);
+    }
+    static Float Set(float x) noexcept {
+        return _mm_set1_ps(x);
+    }
+    static Float Add(Float a, Float b) noexcept {
+        return _mm_add_ps(a, b);
+    }
+    static Float Sub(Float a, Float b) noexcept {
+        return _mm_sub_ps(a, b);
+    }
+    static Float Mul(Float a, Float b) noexcept {
+        return _mm_mul_ps(a, b);
+    }
+    static Float MulAdd(Float a, Float b, Float c) noexcept {
+        return _mm_add_ps(_mm_mul_ps(a, b), c);
+    }
+    // no roundps before sse4.1, truncate and fix the negative ones
+    static Float Floor(Float x) noexcept {
+        Float const t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+        return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.0f)));
+    }
+    static Float Abs(Float x) noexcept {
+        return _mm_andnot_ps(_mm_set1_ps(-0.0f), x);
+    }
+    static Float LessMask(Float a, Float b) noexcept {
+        return _mm_cmplt_ps(a, b);
+    }
+    static Float AndMask(Float mask, Float x) noexcept {
+        return _mm_and_ps(mask, x);
+    }
+    static Float Frexp(Float x, Float& e) noexcept {
+        __m128i bits = _mm_castps_si128(x);
+        e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(126)));
+        bits = _mm_and_si128(bits, _mm_set1_epi32(0x007fffff));
+        bits = _mm_or_si128(bits, _mm_set1_epi32(0x3f000000));
+        return _mm_castsi128_ps(bits);
+    }
+    static Float Log(Float x) noexcept {
+        return LogCephes<Sse2>(x);
+    }
+    static Uint LoadUint(uint32_t const* p) noexcept {
+        return _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+    }
+    static void StoreUint(uint32_t* p, Uint x) noexcept {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), x);
+    }
+    static Uint XorShift(Uint x) noexcept {
+        x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+        x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+        return _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+    }
+    static Float ToUnit(Uint x) noexcept {
+        __m128i const bits = _mm_or_si128(_mm_srli_epi32(x, 9), _mm_set1_epi32(0x3f800000));
+        return _mm_sub_ps(_mm_castsi128_ps(bits), _mm_set1_ps(1.0f));
+    }
+};
+using Native = Sse2;
+#elif defined(QWQDSP_SIMD_NEON)
+struct Neon {
+    using Float = float32x4_t;
+    using Uint = uint32x4_t;
+    static constexpr size_t kWidth = 4;
+
+    static Float Load(float const* p) noexcept {
+        return vld1q_f32(p);
+    }
+    static void Store(float* p, Float x) noexcept {
+        vst1q_f32(p, x);
+    }
+    static Float Set(float x) noexcept {
+        return vdupq_n_f32(x);
+    }
+    static Float Add(Float a, Float b) noexcept {
+        return vaddq_f32(a, b);
+    }
+    static Float Sub(Float a, Float b) noexcept {
+        return vsubq_f32(a, b);
+    }
+    static Float Mul(Float a, Float b) noexcept {
+        return vmulq_f32(a, b);
+    }
+    static Float MulAdd(Float a, Float b, Float c) noexcept {
+#if defined(__aarch64__) || defined(_M_ARM64)
+        return vfmaq_f32(c, a, b);
+#else
+        return vmlaq_f32(c, a, b);
+#endif
+    }
+    static Float Floor(Float x) noexcept {
+#if defined(__aarch64__) || defined(_M_ARM64)
+        return vrndmq_f32(x);
+#else
+        Float const t = vcvtq_f32_s32(vcvtq_s32_f32(x));
+        uint32x4_t const gt = vcgtq_f32(t, x);
+        return vsubq_f32(t, vreinterpretq_f32_u32(vandq_u32(gt, vreinterpretq_u32_f32(vdupq_n_f32(1.0f)))));
+#endif
+    }
+    static Float Abs(Float x) noexcept {
+        return vabsq_f32(x);
+    }
+    static Float LessMask(Float a, Float b) noexcept {
+        return vreinterpretq_f32_u32(vcltq_f32(a, b));
+    }
+    static Float AndMask(Float mask, Float x) noexcept {
+        return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(mask), vreinterpretq_u32_f32(x)));
+    }
+    static Float Frexp(Float x, Float& e) noexcept {
+        uint32x4_t bits = vreinterpretq_u32_f32(x);
+        int32x4_t const ei = vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), vdupq_n_s32(126));
+        e = vcvtq_f32_s32(ei);
+        bits = vandq_u32(bits, vdupq_n_u32(0x007fffff));
+        bits = vorrq_u32(bits, vdupq_n_u32(0x3f000000));
+        return vreinterpretq_f32_u32(bits);
+    }
+    static Float Log(Float x) noexcept {
+        return LogCephes<Neon>(x);
+    }
+    static Uint LoadUint(uint32_t const* p) noexcept {
+        return vld1q_u32(p);
+    }
+    static void StoreUint(uint32_t* p, Uint x) noexcept {
+        vst1q_u32(p, x);
+    }
+    static Uint XorShift(Uint x) noexcept {
+        x = veorq_u32(x, vshlq_n_u32(x, 13));
+        x = veorq_u32(x, vshrq_n_u32(x, 17));
+        return veorq_u32(x, vshlq_n_u32(x, 5));
+    }
+    static Float ToUnit(Uint x) noexcept {
+        uint32x4_t const bits = vorrq_u32(vshrq_n_u32(x, 9), vdupq_n_u32(0x3f800000));
+        return vsubq_f32(vreinterpretq_f32_u32(bits), vdupq_n_f32(1.0f));
+    }
+};
+using Native = Neon;
+#else
+using Native = Scalar;
+#endif
+
+} // namespace qwqdsp_simd
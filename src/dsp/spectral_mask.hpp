@@ -0,0 +1,393 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cassert>
+#include <cstdint>
+#include <span>
+
+#include "arena.hpp"
+#include "simd.hpp"
+
+namespace phaser {
+
+class SpectralPhaserLayer {
+public:
+    void Update(float fs, float fft_size, float hop_size) noexcept {
+        UpdateSpace(fs, fft_size);
+
+        barber_phase_ += barber_freq * hop_size / fs;
+        barber_phase_ -= std::floor(barber_phase_);
+    }
+
+    /**
+     * @brief only the notch spacing, after pitch or morph changed between two Update()
+     */
+    void UpdateSpace(float fs, float fft_size) noexcept {
+        float freq = 440.0f * std::exp2((pitch - 69.0f) / 12.0f);
+        float bins = freq / fs * fft_size;
+        space_ = Warp(bins, morph);
+    }
+
+    float GetLfoPhase() const noexcept {
+        return barber_phase_;
+    }
+
+    void SetLfoPhase(float p) noexcept {
+        barber_phase_ = p;
+    }
+
+    /**
+     * @brief notch spacing in warped bins, valid after Update()
+     */
+    float GetSpace() const noexcept {
+        return space_;
+    }
+
+    static float Warp(float x, float morph) noexcept {
+        float lin = x;
+        float log = std::log(x + 1);
+        return std::lerp(lin, log, morph);
+    }
+
+    bool enable{};
+    float pitch{};
+    float morph{};
+    float phase{};
+    float drywet{};
+    float barber_freq{};
+private:
+    float space_{};
+    float barber_phase_{};
+};
+
+/**
+ * @brief folds every enabled layer (dry/wet included) into one real per-bin gain
+ * @note each layer keeps its own warp table and gain, they are only rebuilt when
+ *       morph / pitch / fs / phase / barber phase / drywet actually changed. a sparse Update() only builds
+ *       the gains and the mask of the bands it is asked for, the rest stays stale until a later hop wants it
+ * @tparam V qwqdsp_simd backend the kernels run on
+ */
+template <class V>
+class BasicSpectralMask {
+public:
+    static constexpr size_t kNumLayers = 4;
+    // bins a sparse Update() switches on or off together, one vector step of the widest backend
+    static constexpr size_t kBandSize = qwqdsp_simd::kMaxWidth;
+
+    /**
+     * @brief takes the tables for up to max_bins from arena, call it inside qwqdsp_memory::Arena::Carve()
+     */
+    void Carve(qwqdsp_memory::Arena& arena, size_t max_bins) noexcept {
+        size_t const padded_bins = qwqdsp_simd::PadSize(max_bins);
+        bin_ = arena.Take<float>(padded_bins);
+        mask_ = arena.Take<float>(padded_bins);
+        mirror_mask_ = arena.Take<float>(qwqdsp_simd::PadSize((max_bins - 1) * 2));
+        band_state_ = arena.Take<BandState>(padded_bins / kBandSize);
+        for (auto& c : cache_) {
+            c.warp = arena.Take<float>(padded_bins);
+            c.gain = arena.Take<float>(padded_bins);
+            c.band_fresh = arena.Take<uint8_t>(padded_bins / kBandSize);
+        }
+    }
+
+    /**
+     * @param num_bins fft_size / 2 + 1, at most the max_bins of Carve(), does not allocate
+     * @param bin_scale bin index multiply this goes into the warp domain of the layers
+     */
+    void Prepare(size_t num_bins, float bin_scale) noexcept {
+        assert(qwqdsp_simd::PadSize(num_bins) <= mask_.size());
+        num_bins_ = num_bins;
+        padded_bins_ = qwqdsp_simd::PadSize(num_bins);
+        num_bands_ = padded_bins_ / kBandSize;
+        fft_size_ = (num_bins - 1) * 2;
+        for (size_t i = 0; i < padded_bins_; ++i) {
+            bin_[i] = static_cast<float>(i) * bin_scale;
+        }
+        for (auto& c : cache_) {
+            c.warp_valid = false;
+            c.enable = false;
+            Invalidate(c);
+        }
+        identity_ = true;
+        mask_valid_ = true;
+        active_ = {};
+        std::fill_n(mask_.begin(), padded_bins_, 1.0f);
+        std::fill_n(mirror_mask_.begin(), qwqdsp_simd::PadSize(fft_size_), 1.0f);
+        std::fill_n(band_state_.begin(), num_bands_, BandState::kOne);
+    }
+
+    /**
+     * @brief call once per hop, then every channel can share GetMask()
+     * @param active empty for every bin, or one flag per kBandSize bins. a band without its flag is neither
+     *               evaluated nor multiplied, it keeps a gain of exactly one
+     */
+    void Update(std::span<SpectralPhaserLayer const, kNumLayers> layers,
+                std::span<uint8_t const> active = {}) noexcept {
+        assert(active.empty() || active.size() >= num_bands_);
+        active_ = active;
+        bool dirty = false;
+        for (size_t l = 0; l < kNumLayers; ++l) {
+            auto const& layer = layers[l];
+            auto& c = cache_[l];
+
+            if (c.enable != layer.enable) {
+                c.enable = layer.enable;
+                dirty = true;
+            }
+            if (!layer.enable) continue;
+
+            if (!c.warp_valid || Changed(c.morph, layer.morph)) {
+                c.morph = layer.morph;
+                BuildWarp(c);
+                c.warp_valid = true;
+                Invalidate(c);
+                dirty = true;
+            }
+
+            float const space = layer.GetSpace();
+            float const offset = layer.phase + layer.GetLfoPhase();
+            if (Changed(c.space, space) || Changed(c.offset, offset) || Changed(c.drywet, layer.drywet)) {
+                c.space = space;
+                c.offset = offset;
+                c.drywet = layer.drywet;
+                Invalidate(c);
+                dirty = true;
+            }
+            if (!c.gain_valid && active.empty()) {
+                BuildGain(c, 0, padded_bins_);
+                c.gain_valid = true;
+                dirty = true;
+            }
+        }
+
+        if (active.empty()) {
+            if (dirty || !mask_valid_) {
+                BuildMask(0, padded_bins_);
+                mask_valid_ = true;
+                std::fill_n(band_state_.begin(), num_bands_, BandState::kBuilt);
+            }
+            return;
+        }
+
+        // a band of ones stays one whatever the layers are, a dense Update() after this one builds everything
+        if (dirty) {
+            std::replace(band_state_.data(), band_state_.data() + num_bands_, BandState::kBuilt, BandState::kStale);
+        }
+        mask_valid_ = false;
+        for (size_t b = 0; b < num_bands_; ++b) {
+            size_t const begin = b * kBandSize;
+            if (!active[b]) {
+                if (band_state_[b] != BandState::kOne) {
+                    FillOne(begin, begin + kBandSize);
+                    band_state_[b] = BandState::kOne;
+                }
+                continue;
+            }
+            if (band_state_[b] == BandState::kBuilt) continue;
+
+            for (auto& c : cache_) {
+                if (!c.enable || c.gain_valid || c.band_fresh[b]) continue;
+                BuildGain(c, begin, begin + kBandSize);
+                c.band_fresh[b] = 1;
+            }
+            BuildMask(begin, begin + kBandSize);
+            band_state_[b] = BandState::kBuilt;
+        }
+    }
+
+    /**
+     * @return true if no layer is enabled, the mask is all one
+     */
+    bool IsIdentity() const noexcept {
+        return identity_;
+    }
+
+    std::span<float const> GetMask() const noexcept {
+        return {mask_.data(), num_bins_};
+    }
+
+    /**
+     * @param re padded to qwqdsp_simd::PadSize(num_bins)
+     * @param im padded to qwqdsp_simd::PadSize(num_bins)
+     */
+    void Apply(float* re, float* im) const noexcept {
+        if (identity_) return;
+        if (active_.empty()) {
+            Multiply(re, im, mask_.data(), padded_bins_);
+            return;
+        }
+        // runs of active bands, the others have a gain of one
+        for (size_t b = 0; b < num_bands_;) {
+            if (!active_[b]) {
+                ++b;
+                continue;
+            }
+            size_t end = b + 1;
+            while (end < num_bands_ && active_[end]) ++end;
+            size_t const i = b * kBandSize;
+            Multiply(re + i, im + i, mask_.data() + i, (end - b) * kBandSize);
+            b = end;
+        }
+    }
+
+    /**
+     * @brief apply to a full complex spectrum, X[N-k] gets the same gain as X[k]
+     * @param re fft_size
+     * @param im fft_size
+     */
+    void ApplyMirrored(float* re, float* im) const noexcept {
+        if (identity_) return;
+        if (active_.empty()) {
+            Multiply(re, im, mirror_mask_.data(), fft_size_);
+            return;
+        }
+        // [i, i + kBandSize) of the upper half holds the bins fft_size - i down to fft_size - i - kBandSize + 1,
+        // they come from two bands
+        for (size_t i = 0; i < fft_size_; i += kBandSize) {
+            size_t const b = i < fft_size_ / 2 ? i / kBandSize : (fft_size_ - i) / kBandSize;
+            bool const wanted = i < fft_size_ / 2 ? active_[b] : active_[b] || active_[b - 1];
+            if (wanted) Multiply(re + i, im + i, mirror_mask_.data() + i, kBandSize);
+        }
+    }
+private:
+    enum class BandState : uint8_t {
+        // the layers changed since it was built
+        kStale,
+        kBuilt,
+        // left out of the last sparse Update(), mask and mirror are exactly one
+        kOne,
+    };
+
+    struct LayerCache {
+        std::span<float> warp;
+        std::span<float> gain;
+        // per band, only read while !gain_valid: this band of gain is built for the current values
+        std::span<uint8_t> band_fresh;
+        float morph{};
+        float space{};
+        float offset{};
+        float drywet{};
+        bool enable{};
+        bool warp_valid{};
+        bool gain_valid{};
+    };
+
+    // the exact compare of a cache against the layer, any other bits build again
+    static bool Changed(float cached, float value) noexcept {
+        return std::bit_cast<uint32_t>(cached) != std::bit_cast<uint32_t>(value);
+    }
+
+    static void Invalidate(LayerCache& c) noexcept {
+        c.gain_valid = false;
+        std::fill(c.band_fresh.begin(), c.band_fresh.end(), uint8_t{0});
+    }
+
+    static void Multiply(float* re, float* im, float const* m, size_t n) noexcept {
+        for (size_t i = 0; i < n; i += V::kWidth) {
+            auto const g = V::Load(m + i);
+            V::Store(re + i, V::Mul(V::Load(re + i), g));
+            V::Store(im + i, V::Mul(V::Load(im + i), g));
+        }
+    }
+
+    // lerp(bin, log(bin + 1), morph)
+    void BuildWarp(LayerCache& c) noexcept {
+        auto const morph = V::Set(c.morph);
+        auto const one = V::Set(1.0f);
+        for (size_t i = 0; i < padded_bins_; i += V::kWidth) {
+            auto const lin = V::Load(bin_.data() + i);
+            auto const log = V::Log(V::Add(lin, one));
+            V::Store(c.warp.data() + i, V::MulAdd(morph, V::Sub(log, lin), lin));
+        }
+    }
+
+    /**
+     * @brief dry + wet * (SinReaktor(frac(warp / space + offset)) * 0.5 + 0.5)
+     * @note SinReaktor is the poly sin approximate from reaktor, -110dB 3rd harmonic
+     */
+    void BuildGain(LayerCache& c, size_t begin, size_t end) noexcept {
+        auto const inv_space = V::Set(1.0f / c.space);
+        auto const offset = V::Set(c.offset);
+        auto const half = V::Set(0.5f);
+        auto const two = V::Set(2.0f);
+        auto const k0 = V::Set(-0.540347434104161f);
+        auto const k1 = V::Set(2.535656174488765f);
+        auto const k2 = V::Set(-5.166512943349853f);
+        auto const k3 = V::Set(3.141592653589793f);
+        auto const gain_offset = V::Set(1.0f - 0.5f * c.drywet);
+        auto const gain_scale = V::Set(0.5f * c.drywet);
+
+        for (size_t i = begin; i < end; i += V::kWidth) {
+            auto p = V::MulAdd(V::Load(c.warp.data() + i), inv_space, offset);
+            p = V::Sub(p, V::Floor(p));
+
+            auto const x = V::Sub(V::Mul(two, V::Abs(V::Sub(p, half))), half);
+            auto const x2 = V::Mul(x, x);
+            auto u = V::MulAdd(k0, x2, k1);
+            u = V::MulAdd(u, x2, k2);
+            u = V::MulAdd(u, x2, k3);
+            auto const sin = V::Mul(u, x);
+
+            V::Store(c.gain.data() + i, V::MulAdd(sin, gain_scale, gain_offset));
+        }
+    }
+
+    // bins [begin, end) of the mask and the mirror of them
+    void BuildMask(size_t begin, size_t end) noexcept {
+        identity_ = true;
+        for (auto const& c : cache_) {
+            if (!c.enable) continue;
+
+            if (identity_) {
+                std::copy_n(c.gain.data() + begin, end - begin, mask_.data() + begin);
+                identity_ = false;
+            }
+            else {
+                for (size_t i = begin; i < end; i += V::kWidth) {
+                    V::Store(mask_.data() + i, V::Mul(V::Load(mask_.data() + i), V::Load(c.gain.data() + i)));
+                }
+            }
+        }
+        if (identity_) {
+            std::fill_n(mask_.data() + begin, end - begin, 1.0f);
+        }
+        BuildMirror(begin, end);
+    }
+
+    void FillOne(size_t begin, size_t end) noexcept {
+        std::fill_n(mask_.data() + begin, end - begin, 1.0f);
+        BuildMirror(begin, end);
+    }
+
+    void BuildMirror(size_t begin, size_t end) noexcept {
+        size_t const half = fft_size_ / 2;
+        size_t const last = std::min(end, half + 1);
+        if (begin >= last) return;
+        std::copy_n(mask_.data() + begin, last - begin, mirror_mask_.data() + begin);
+        for (size_t i = std::max(begin, size_t{1}); i < std::min(end, half); ++i) {
+            mirror_mask_[fft_size_ - i] = mask_[i];
+        }
+    }
+
+    size_t num_bins_{};
+    size_t padded_bins_{};
+    size_t fft_size_{};
+    size_t num_bands_{};
+    bool identity_{true};
+    // every band of mask_ is built for the layers, false after a sparse Update()
+    bool mask_valid_{true};
+    // the flags of the last Update(), owned by the caller
+    std::span<uint8_t const> active_;
+    std::array<LayerCache, kNumLayers> cache_;
+    // carved from the arena of the owner, sized for the max_bins of Carve()
+    std::span<float> bin_;
+    std::span<float> mask_;
+    std::span<float> mirror_mask_;
+    std::span<BandState> band_state_;
+};
+
+using SpectralMask = BasicSpectralMask<qwqdsp_simd::Native>;
+
+} // namespace phaser
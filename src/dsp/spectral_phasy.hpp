@@ -0,0 +1,223 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <random>
+#include <span>
+
+#include "arena.hpp"
+#include "simd.hpp"
+
+namespace phaser {
+
+enum class PhasyType {
+    // every bin turned by a fixed random phase
+    kPhase,
+    // every bin scaled by a random gain in [0, 2), drawn again every hop
+    kGain
+};
+
+/**
+ * @param smooth time constant the gains glide with in seconds, 0 for none
+ * @return glide of BasicSpectralPhasy::Update() for hops of hop_size samples
+ */
+inline float PhasyGlide(float smooth, float hop_size, float fs) noexcept {
+    return smooth > 0.0f ? std::exp(-hop_size / (smooth * fs)) : 0.0f;
+}
+
+// splitmix32, advances state and returns the next draw
+inline uint32_t SplitMix32(uint32_t& state) noexcept {
+    state += 0x9e3779b9u;
+    uint32_t z = state;
+    z = (z ^ (z >> 16)) * 0x85ebca6bu;
+    z = (z ^ (z >> 13)) * 0xc2b2ae35u;
+    return z ^ (z >> 16);
+}
+
+/**
+ * @return a different seed every call, only the first call of the process asks std::random_device
+ */
+inline uint32_t NextPhasySeed() {
+    static std::atomic<uint32_t> counter{std::random_device{}()};
+    uint32_t state = counter.fetch_add(0x9e3779b9u, std::memory_order_relaxed);
+    return SplitMix32(state);
+}
+
+/**
+ * @brief the random part of phasy, one table of per bin phases or gains shared by every channel
+ * @note the gains come from kMaxWidth xorshift32 generators, one vector step draws V::kWidth of them
+ * @tparam V qwqdsp_simd backend the kernels run on
+ */
+template <class V>
+class BasicSpectralPhasy {
+public:
+    /**
+     * @brief takes the tables for up to max_bins from arena, call it inside qwqdsp_memory::Arena::Carve()
+     */
+    void Carve(qwqdsp_memory::Arena& arena, size_t max_bins) noexcept {
+        size_t const max_size = (max_bins - 1) * 2;
+        drawn_re_ = arena.Take<float>(max_bins);
+        drawn_im_ = arena.Take<float>(max_bins);
+        phase_re_ = arena.Take<float>(qwqdsp_simd::PadSize(max_size));
+        phase_im_ = arena.Take<float>(qwqdsp_simd::PadSize(max_size));
+        gain_ = arena.Take<float>(qwqdsp_simd::PadSize(max_bins));
+        mirror_gain_ = arena.Take<float>(qwqdsp_simd::PadSize(max_size));
+    }
+
+    /**
+     * @brief draws the phases and seeds the gains, call it after Carve() and before Prepare()
+     * @note only picks entries of the phase table, no trig per instance
+     */
+    void Seed(uint32_t seed) noexcept {
+        auto const& table = GetPhaseTable();
+        for (size_t i = 0; i < drawn_re_.size(); ++i) {
+            size_t const k = SplitMix32(seed) >> (32 - kPhaseBits);
+            drawn_re_[i] = table.re[k];
+            drawn_im_[i] = table.im[k];
+        }
+
+        // none of the generators may start at 0
+        for (auto& s : state_) {
+            s = SplitMix32(seed) | 1u;
+        }
+    }
+
+    /**
+     * @param num_bins fft_size / 2 + 1, at most the max_bins of Carve(), does not allocate
+     */
+    void Prepare(size_t num_bins) noexcept {
+        assert(num_bins <= drawn_re_.size());
+        padded_bins_ = qwqdsp_simd::PadSize(num_bins);
+        fft_size_ = (num_bins - 1) * 2;
+
+        // X[N-k] is turned the other way, DC and nyquist only keep the real part like the real ifft does
+        size_t const half = fft_size_ / 2;
+        std::copy_n(drawn_re_.begin(), half + 1, phase_re_.begin());
+        std::copy_n(drawn_im_.begin(), half + 1, phase_im_.begin());
+        phase_im_[0] = 0.0f;
+        phase_im_[half] = 0.0f;
+        for (size_t i = 1; i < half; ++i) {
+            phase_re_[fft_size_ - i] = drawn_re_[i];
+            phase_im_[fft_size_ - i] = -drawn_im_[i];
+        }
+        std::fill_n(gain_.begin(), padded_bins_, 1.0f);
+        std::fill_n(mirror_gain_.begin(), qwqdsp_simd::PadSize(fft_size_), 1.0f);
+    }
+
+    /**
+     * @brief call once per hop before Apply(), draws new gains for PhasyType::kGain
+     * @param glide part of the old gain kept every hop, 0 jumps straight to the new draw
+     */
+    void Update(PhasyType type, float glide) noexcept {
+        type_ = type;
+        if (type != PhasyType::kGain) return;
+
+        auto const two = V::Set(2.0f);
+        auto const keep = V::Set(glide);
+        for (size_t i = 0; i < padded_bins_; i += qwqdsp_simd::kMaxWidth) {
+            for (size_t j = 0; j < qwqdsp_simd::kMaxWidth; j += V::kWidth) {
+                auto const s = V::XorShift(V::LoadUint(state_.data() + j));
+                V::StoreUint(state_.data() + j, s);
+                auto const target = V::Mul(two, V::ToUnit(s));
+                auto const g = V::Load(gain_.data() + i + j);
+                V::Store(gain_.data() + i + j, V::MulAdd(keep, V::Sub(g, target), target));
+            }
+        }
+
+        size_t const half = fft_size_ / 2;
+        std::copy_n(gain_.begin(), half + 1, mirror_gain_.begin());
+        for (size_t i = 1; i < half; ++i) {
+            mirror_gain_[fft_size_ - i] = gain_[i];
+        }
+    }
+
+    /**
+     * @param re padded to qwqdsp_simd::PadSize(num_bins)
+     * @param im padded to qwqdsp_simd::PadSize(num_bins)
+     */
+    void Apply(float* re, float* im) const noexcept {
+        if (type_ == PhasyType::kGain) {
+            Multiply(re, im, gain_.data(), padded_bins_);
+        }
+        else {
+            Rotate(re, im, phase_re_.data(), phase_im_.data(), padded_bins_);
+        }
+    }
+
+    /**
+     * @brief apply to a full complex spectrum, X[N-k] gets the conjugate of what X[k] gets
+     * @param re fft_size
+     * @param im fft_size
+     */
+    void ApplyMirrored(float* re, float* im) const noexcept {
+        if (type_ == PhasyType::kGain) {
+            Multiply(re, im, mirror_gain_.data(), fft_size_);
+        }
+        else {
+            Rotate(re, im, phase_re_.data(), phase_im_.data(), fft_size_);
+        }
+    }
+private:
+    // the phases a bin can be turned by, pi / kNumPhases apart in [0, pi)
+    static constexpr uint32_t kPhaseBits = 10;
+    static constexpr size_t kNumPhases = size_t{1} << kPhaseBits;
+
+    struct PhaseTable {
+        std::array<float, kNumPhases> re;
+        std::array<float, kNumPhases> im;
+    };
+
+    // built by the first Seed() of the process, shared by every instance after that
+    static PhaseTable const& GetPhaseTable() noexcept {
+        static PhaseTable const table = [] {
+            PhaseTable t;
+            for (size_t k = 0; k < kNumPhases; ++k) {
+                double const phase = std::numbers::pi * static_cast<double>(k) / static_cast<double>(kNumPhases);
+                t.re[k] = static_cast<float>(std::cos(phase));
+                t.im[k] = static_cast<float>(std::sin(phase));
+            }
+            return t;
+        }();
+        return table;
+    }
+
+    static void Multiply(float* re, float* im, float const* g, size_t n) noexcept {
+        for (size_t i = 0; i < n; i += V::kWidth) {
+            auto const x = V::Load(g + i);
+            V::Store(re + i, V::Mul(V::Load(re + i), x));
+            V::Store(im + i, V::Mul(V::Load(im + i), x));
+        }
+    }
+
+    static void Rotate(float* re, float* im, float const* pr, float const* pi, size_t n) noexcept {
+        for (size_t i = 0; i < n; i += V::kWidth) {
+            auto const a = V::Load(re + i);
+            auto const b = V::Load(im + i);
+            auto const c = V::Load(pr + i);
+            auto const d = V::Load(pi + i);
+            V::Store(re + i, V::Sub(V::Mul(a, c), V::Mul(b, d)));
+            V::Store(im + i, V::MulAdd(a, d, V::Mul(b, c)));
+        }
+    }
+
+    size_t padded_bins_{};
+    size_t fft_size_{};
+    PhasyType type_{};
+    std::array<uint32_t, qwqdsp_simd::kMaxWidth> state_{};
+    // carved from the arena of the owner, sized for the max_bins of Carve()
+    std::span<float> drawn_re_;
+    std::span<float> drawn_im_;
+    // full spectrum, the second half mirrored
+    std::span<float> phase_re_;
+    std::span<float> phase_im_;
+    std::span<float> gain_;
+    std::span<float> mirror_gain_;
+};
+
+using SpectralPhasy = BasicSpectralPhasy<qwqdsp_simd::Native>;
+
+} // namespace phaser
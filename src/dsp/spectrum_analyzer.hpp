@@ -0,0 +1,56 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+
+#include "triple_buffer.hpp"
+
+namespace phaser {
+
+/**
+ * @brief spectrum and mask the editor draws, made from the ffts the phaser does anyway
+ * @note the audio thread only fills frames while a view is registered
+ */
+class AnalyzerTap {
+public:
+    static constexpr size_t kNumPoints = 256;
+    static constexpr float kMinFreq = 20.0f;
+
+    struct Frame {
+        // input of channel 0, the rms with channel 1 when they share a packed fft. 1 is a full scale sine
+        std::array<float, kNumPoints> magnitude{};
+        // lowest gain of the bins under a point, so no notch falls between two points
+        std::array<float, kNumPoints> mask{};
+        float fs{};
+    };
+
+    /**
+     * @param i point index, log spaced from kMinFreq to fs / 2
+     */
+    static float PointFreq(float i, float fs) noexcept {
+        return kMinFreq * std::pow(fs * 0.5f / kMinFreq, i / static_cast<float>(kNumPoints - 1));
+    }
+
+    // ---------------------------------------- message thread ----------------------------------------
+
+    void AddView() noexcept {
+        num_views_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void RemoveView() noexcept {
+        num_views_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // ---------------------------------------- audio thread ----------------------------------------
+
+    bool IsWanted() const noexcept {
+        return num_views_.load(std::memory_order_relaxed) != 0;
+    }
+
+    qwqdsp_parallel::TripleBuffer<Frame> frames;
+private:
+    std::atomic<int> num_views_{};
+};
+
+} // namespace phaser
@@ -0,0 +1,52 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace qwqdsp_parallel {
+
+/**
+ * @brief one writer hands whole values to one reader, neither ever waits
+ * @note the reader always gets the newest published value, values it did not fetch in time are dropped
+ */
+template <class T>
+class TripleBuffer {
+public:
+    // ---------------------------------------- writer ----------------------------------------
+
+    /**
+     * @return the slot to fill, it is not seen by the reader before Publish()
+     */
+    T& Back() noexcept {
+        return slots_[back_];
+    }
+
+    void Publish() noexcept {
+        back_ = middle_.exchange(back_ | kNew, std::memory_order_acq_rel) & kIndex;
+    }
+
+    // ---------------------------------------- reader ----------------------------------------
+
+    /**
+     * @return true if a value was published since the last Fetch(), Front() holds it now
+     */
+    bool Fetch() noexcept {
+        if ((middle_.load(std::memory_order_relaxed) & kNew) == 0) return false;
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndex;
+        return true;
+    }
+
+    T const& Front() const noexcept {
+        return slots_[front_];
+    }
+private:
+    static constexpr uint32_t kIndex = 3;
+    static constexpr uint32_t kNew = 4;
+
+    std::array<T, 3> slots_{};
+    uint32_t back_{0};
+    std::atomic<uint32_t> middle_{1};
+    uint32_t front_{2};
+};
+
+} // namespace qwqdsp_parallel
@@ -0,0 +1,217 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+
+namespace qwqdsp_window {
+
+/**
+ * @brief analyze windows with a table for every power of two size in [kMinTableSize, kMaxTableSize]
+ * @note all tables are periodic (or, for kbd, meet their overlap condition) so they overlap add without ripple
+ */
+enum class Shape {
+    kHann,
+    // squared it is a hann, so analyze and synthsis together taper like one hann
+    kSqrtHann,
+    // 4 term, -92dB sidelobes, wide mainlobe
+    kBlackmanHarris,
+    // kaiser bessel derived, alpha = kKbdAlpha
+    kKbd,
+    kNumShapes
+};
+
+static constexpr size_t kMinTableSize = 256;
+static constexpr size_t kMaxTableSize = 8192;
+static constexpr double kKbdAlpha = 4.0;
+
+namespace table_detail {
+inline constexpr double kPi = 3.141592653589793238462643383279502884;
+
+// taylor series, only used for small x
+constexpr double CosSmall(double x) noexcept {
+    double const x2 = x * x;
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k <= 9; ++k) {
+        term *= -x2 / static_cast<double>((2 * k - 1) * (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double SinSmall(double x) noexcept {
+    double const x2 = x * x;
+    double sum = x;
+    double term = x;
+    for (int k = 1; k <= 9; ++k) {
+        term *= -x2 / static_cast<double>((2 * k) * (2 * k + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+/**
+ * @return cos(2 pi n / kSize) for n in [0, kSize / 4], by rotating one step at a time, about 1e-13 off at the end
+ */
+template <size_t kSize>
+constexpr std::array<double, kSize / 4 + 1> QuarterCos() noexcept {
+    std::array<double, kSize / 4 + 1> c{};
+    double const step = 2.0 * kPi / static_cast<double>(kSize);
+    double const cos_step = CosSmall(step);
+    double const sin_step = SinSmall(step);
+    double re = 1.0;
+    double im = 0.0;
+    for (auto& x : c) {
+        x = re;
+        double const t = re * cos_step - im * sin_step;
+        im = im * cos_step + re * sin_step;
+        re = t;
+    }
+    return c;
+}
+
+constexpr double Sqrt(double x) noexcept {
+    if (x <= 0.0) return 0.0;
+    // halving the exponent is within 4%, three newton steps take that below 1e-13
+    double y = std::bit_cast<double>((std::bit_cast<uint64_t>(x) >> 1) + (uint64_t{1023} << 51));
+    for (int i = 0; i < 3; ++i) {
+        y = 0.5 * (y + x / y);
+    }
+    return y;
+}
+
+// modified bessel function of the first kind, order 0
+constexpr double BesselI0(double x) noexcept {
+    double const q = 0.25 * x * x;
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; term > sum * 1e-12; ++k) {
+        term *= q / static_cast<double>(k * k);
+        sum += term;
+    }
+    return sum;
+}
+
+template <Shape kShape, size_t kSize>
+struct Table;
+
+template <Shape kShape, size_t kSize>
+consteval std::array<float, kSize> Generate() {
+    static_assert(kSize % 8 == 0);
+    std::array<float, kSize> w{};
+    if constexpr (kShape == Shape::kKbd) {
+        // the running sum of a kaiser window of kSize / 2 + 1 points, mirrored
+        constexpr size_t kHalf = kSize / 2;
+        std::array<double, kHalf + 1> kaiser{};
+        for (size_t j = 0; j <= kHalf / 2; ++j) {
+            double const r = 2.0 * static_cast<double>(j) / static_cast<double>(kHalf) - 1.0;
+            kaiser[j] = BesselI0(kPi * kKbdAlpha * Sqrt(1.0 - r * r));
+        }
+        for (size_t j = kHalf / 2 + 1; j <= kHalf; ++j) {
+            kaiser[j] = kaiser[kHalf - j];
+        }
+        double total = 0.0;
+        for (double v : kaiser) {
+            total += v;
+        }
+        double acc = 0.0;
+        for (size_t n = 0; n < kHalf; ++n) {
+            acc += kaiser[n];
+            w[n] = static_cast<float>(Sqrt(acc / total));
+        }
+        // written in order, constant evaluation is slow at filling an array out of order
+        for (size_t n = kHalf; n < kSize; ++n) {
+            w[n] = w[kSize - 1 - n];
+        }
+    }
+    else if constexpr (kSize < kMaxTableSize) {
+        // a cosine sum window of a smaller size is every other point of the bigger one
+        for (size_t n = 0; n < kSize; ++n) {
+            w[n] = Table<kShape, kSize * 2>::kData[2 * n];
+        }
+    }
+    else {
+        constexpr size_t kQuarter = kSize / 4;
+        auto const quarter = QuarterCos<kSize>();
+        // cos(2 pi k n / kSize)
+        auto harmonic = [&quarter](size_t k, size_t n) {
+            size_t m = k * n % kSize;
+            if (m > 2 * kQuarter) m = kSize - m;
+            return m > kQuarter ? -quarter[2 * kQuarter - m] : quarter[m];
+        };
+        // periodic, w[kSize - n] = w[n], the second half is copied below
+        for (size_t n = 0; n <= kSize / 2; ++n) {
+            double v{};
+            if constexpr (kShape == Shape::kHann) {
+                v = 0.5 - 0.5 * harmonic(1, n);
+            }
+            else if constexpr (kShape == Shape::kSqrtHann) {
+                v = Sqrt(0.5 - 0.5 * harmonic(1, n));
+            }
+            else {
+                v = 0.35875 - 0.48829 * harmonic(1, n) + 0.14128 * harmonic(2, n) - 0.01168 * harmonic(3, n);
+            }
+            w[n] = static_cast<float>(v);
+        }
+        for (size_t n = kSize / 2 + 1; n < kSize; ++n) {
+            w[n] = w[kSize - n];
+        }
+    }
+    return w;
+}
+
+template <Shape kShape, size_t kSize>
+struct Table {
+    // starts on a cache line, like the buffers it is multiplied with
+    alignas(64) static constexpr std::array<float, kSize> kData = Generate<kShape, kSize>();
+};
+
+template <Shape kShape, size_t... kLog2>
+constexpr std::array<std::span<float const>, sizeof...(kLog2)> MakeSpans(std::index_sequence<kLog2...>) noexcept {
+    return {std::span<float const>{Table<kShape, (kMinTableSize << kLog2)>::kData}...};
+}
+} // namespace table_detail
+
+static constexpr size_t kNumTableSizes = std::bit_width(kMaxTableSize / kMinTableSize);
+
+/**
+ * @param size a power of two in [kMinTableSize, kMaxTableSize]
+ * @return the window, built at compile time
+ */
+inline std::span<float const> GetTable(Shape shape, size_t size) noexcept {
+    using Sizes = std::make_index_sequence<kNumTableSizes>;
+    static constexpr std::array<std::array<std::span<float const>, kNumTableSizes>,
+                                static_cast<size_t>(Shape::kNumShapes)>
+        kTables{
+            table_detail::MakeSpans<Shape::kHann>(Sizes{}),
+            table_detail::MakeSpans<Shape::kSqrtHann>(Sizes{}),
+            table_detail::MakeSpans<Shape::kBlackmanHarris>(Sizes{}),
+            table_detail::MakeSpans<Shape::kKbd>(Sizes{}),
+        };
+    size_t const index = static_cast<size_t>(std::countr_zero(size / kMinTableSize));
+    return kTables[static_cast<size_t>(shape)][index];
+}
+
+/**
+ * @brief synthsis = analyze / sum of analyze^2 over the frames overlapping a sample, so analyze and
+ *        synthsis windowed frames overlap add to exactly the input at any hop
+ * @param hop_size divides analyze.size()
+ */
+inline void BuildSynthsis(std::span<float const> analyze, std::span<float> synthsis, size_t hop_size) noexcept {
+    size_t const size = analyze.size();
+    for (size_t i = 0; i < hop_size; ++i) {
+        double wsum = 0.0;
+        for (size_t j = i; j < size; j += hop_size) {
+            wsum += static_cast<double>(analyze[j]) * static_cast<double>(analyze[j]);
+        }
+        float const norm = wsum > 0.0 ? static_cast<float>(1.0 / wsum) : 0.0f;
+        for (size_t j = i; j < size; j += hop_size) {
+            synthsis[j] = analyze[j] * norm;
+        }
+    }
+}
+
+} // namespace qwqdsp_window
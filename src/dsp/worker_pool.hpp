@@ -0,0 +1,166 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#elif defined(_M_ARM64)
+#include <intrin.h>
+#endif
+
+namespace qwqdsp_parallel {
+
+inline void CpuPause() noexcept {
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    _mm_pause();
+#elif defined(_M_ARM64)
+    __yield();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+/**
+ * @brief fork join pool for short jobs, the caller takes part in every Run()
+ * @note Run() does not allocate or lock. workers spin for a while after a run, then park on an atomic
+ *       wait, waking a parked worker is a single notify
+ */
+class WorkerPool {
+public:
+    // about 50us of spinning on a recent x86, the next hop usually comes before that runs out
+    static constexpr size_t kSpinCount = 1 << 12;
+    // most jobs of a Run()
+    static constexpr size_t kMaxJobs = 0xffff;
+
+    WorkerPool() = default;
+    WorkerPool(WorkerPool const&) = delete;
+    WorkerPool& operator=(WorkerPool const&) = delete;
+
+    ~WorkerPool() {
+        Stop();
+    }
+
+    /**
+     * @brief starts num_workers threads besides the caller, not realtime safe
+     */
+    void Start(size_t num_workers) {
+        if (num_workers == workers_.size()) return;
+        Stop();
+        stop_.store(false);
+        for (size_t i = 0; i < num_workers; ++i) {
+            workers_.emplace_back([this, slot = i + 1] { WorkerLoop(slot); });
+        }
+    }
+
+    void Stop() {
+        if (workers_.empty()) return;
+        stop_.store(true);
+        generation_.fetch_add(1);
+        generation_.notify_all();
+        for (auto& w : workers_) {
+            w.join();
+        }
+        workers_.clear();
+    }
+
+    /**
+     * @return number of threads a Run() can use, the caller included
+     */
+    size_t GetNumSlots() const noexcept {
+        return workers_.size() + 1;
+    }
+
+    /**
+     * @brief calls func(job, slot) for every job in [0, num_jobs) and returns once all are done
+     * @param func void(size_t job, size_t slot), slot is in [0, GetNumSlots()) and unique among the
+     *             jobs running at the same time, 0 is the caller
+     */
+    template <class Func>
+    void Run(size_t num_jobs, Func& func) noexcept {
+        RunErased(num_jobs, [](void* ctx, size_t job, size_t slot) { (*static_cast<Func*>(ctx))(job, slot); },
+                  &func);
+    }
+private:
+    using JobFunc = void (*)(void*, size_t, size_t);
+
+    void RunErased(size_t num_jobs, JobFunc func, void* ctx) noexcept {
+        assert(num_jobs <= kMaxJobs);
+        if (workers_.empty() || num_jobs < 2) {
+            for (size_t i = 0; i < num_jobs; ++i) {
+                func(ctx, i, 0);
+            }
+            return;
+        }
+
+        uint32_t const gen = generation_.load(std::memory_order_relaxed) + 1;
+        func_ = func;
+        ctx_ = ctx;
+        pending_.store(num_jobs, std::memory_order_relaxed);
+        // the generation and the job count in the high bits keep a late worker from claiming jobs of the next
+        // run, one load sees both
+        jobs_.store(uint64_t{gen} << 32 | uint64_t{num_jobs} << 16, std::memory_order_release);
+        generation_.store(gen);
+        if (num_parked_.load() != 0) {
+            generation_.notify_all();
+        }
+
+        Work(gen, 0);
+        while (pending_.load(std::memory_order_acquire) != 0) {
+            CpuPause();
+        }
+    }
+
+    void Work(uint32_t gen, size_t slot) noexcept {
+        for (;;) {
+            uint64_t jobs = jobs_.load(std::memory_order_acquire);
+            if (static_cast<uint32_t>(jobs >> 32) != gen) return;
+            size_t const num_jobs = static_cast<size_t>((jobs >> 16) & kMaxJobs);
+            size_t const job = static_cast<size_t>(jobs & kMaxJobs);
+            if (job >= num_jobs) return;
+            if (!jobs_.compare_exchange_weak(jobs, jobs + 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                continue;
+            }
+            // the run can not finish before this job did, so func_ and ctx_ are still the ones of gen
+            func_(ctx_, job, slot);
+            pending_.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    void WorkerLoop(size_t slot) noexcept {
+        uint32_t seen = generation_.load();
+        for (;;) {
+            uint32_t gen = seen;
+            for (size_t i = 0; i < kSpinCount && gen == seen; ++i) {
+                CpuPause();
+                gen = generation_.load(std::memory_order_acquire);
+            }
+            while (gen == seen) {
+                // a Run() either sees the count or its new generation makes the wait return
+                num_parked_.fetch_add(1);
+                generation_.wait(seen);
+                num_parked_.fetch_sub(1);
+                gen = generation_.load();
+            }
+
+            if (stop_.load()) return;
+            seen = gen;
+            Work(gen, slot);
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::atomic<bool> stop_{};
+    std::atomic<uint32_t> generation_{};
+    std::atomic<uint32_t> num_parked_{};
+    // generation << 32 | num jobs << 16 | next job
+    std::atomic<uint64_t> jobs_{};
+    std::atomic<size_t> pending_{};
+    JobFunc func_{};
+    void* ctx_{};
+};
+
+} // namespace qwqdsp_parallel
@@ -0,0 +1,107 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief binary plugin state, little endian
+ *
+ *   u32 kMagic, u16 version, u16 count
+ *   count times: u32 Hash(parameter id), f32 plain value
+ *
+ * @note a state of a version this build does not know is rejected, a newer format bumps kVersion and
+ *       Decode() branches on it. a parameter that is not in the state keeps its default
+ */
+namespace plugin_state {
+
+static constexpr uint32_t kMagic = 0x53485053; // "SPHS"
+static constexpr uint16_t kVersion = 1;
+static constexpr size_t kHeaderSize = 8;
+static constexpr size_t kEntrySize = 8;
+
+struct Entry {
+    uint32_t id_hash;
+    float value;
+};
+
+// fnv-1a, stable across builds and platforms
+constexpr uint32_t Hash(std::string_view id) noexcept {
+    uint32_t h = 2166136261u;
+    for (char c : id) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+namespace detail {
+inline void Put(std::vector<uint8_t>& out, uint32_t x, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<uint8_t>(x >> (8 * i)));
+    }
+}
+
+inline uint32_t Get(uint8_t const* in, size_t bytes) noexcept {
+    uint32_t x = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        x |= uint32_t{in[i]} << (8 * i);
+    }
+    return x;
+}
+} // namespace detail
+
+inline std::vector<uint8_t> Encode(std::span<Entry const> entries) {
+    std::vector<uint8_t> out;
+    out.reserve(kHeaderSize + kEntrySize * entries.size());
+    detail::Put(out, kMagic, 4);
+    detail::Put(out, kVersion, 2);
+    detail::Put(out, static_cast<uint32_t>(entries.size()), 2);
+    for (auto const& e : entries) {
+        uint32_t bits;
+        std::memcpy(&bits, &e.value, 4);
+        detail::Put(out, e.id_hash, 4);
+        detail::Put(out, bits, 4);
+    }
+    return out;
+}
+
+/**
+ * @return true if data starts like a state of this format, any version
+ */
+inline bool IsState(void const* data, size_t size) noexcept {
+    return size >= kHeaderSize && detail::Get(static_cast<uint8_t const*>(data), 4) == kMagic;
+}
+
+/**
+ * @return the version of a state, IsState() must hold
+ */
+inline uint16_t GetVersion(void const* data) noexcept {
+    return static_cast<uint16_t>(detail::Get(static_cast<uint8_t const*>(data) + 4, 2));
+}
+
+/**
+ * @return false if data is no state, is of an unknown version or is cut short, entries is left empty then
+ */
+inline bool Decode(void const* data, size_t size, std::vector<Entry>& entries) {
+    entries.clear();
+    if (!IsState(data, size)) return false;
+    if (GetVersion(data) != kVersion) return false;
+    auto const* in = static_cast<uint8_t const*>(data);
+    size_t const count = detail::Get(in + 6, 2);
+    if (size < kHeaderSize + count * kEntrySize) return false;
+
+    entries.resize(count);
+    in += kHeaderSize;
+    for (auto& e : entries) {
+        e.id_hash = detail::Get(in, 4);
+        uint32_t const bits = detail::Get(in + 4, 4);
+        std::memcpy(&e.value, &bits, 4);
+        in += kEntrySize;
+    }
+    return true;
+}
+
+} // namespace plugin_state
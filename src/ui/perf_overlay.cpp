@@ -0,0 +1,94 @@
+#include "perf_overlay.hpp"
+
+#include "../PluginProcessor.h"
+
+PerfOverlay::PerfOverlay(EmptyAudioProcessor& p)
+    : processor_(p) {
+    setInterceptsMouseClicks(false, false);
+    first_cycles_ = qwqdsp_perf::ReadCycles();
+    first_time_ = std::chrono::steady_clock::now();
+    startTimerHz(kRefreshHz);
+}
+
+void PerfOverlay::paint(juce::Graphics& g) {
+    g.setColour(juce::Colours::black.withAlpha(0.5f));
+    g.fillRoundedRectangle(getLocalBounds().toFloat(), 3.0f);
+    g.setColour(juce::Colours::white);
+    g.setFont(11.0f);
+    auto b = getLocalBounds().reduced(4, 1);
+    int const line = b.getHeight() / 3;
+    g.drawText(callback_text_, b.removeFromTop(line), juce::Justification::centredLeft);
+    g.drawText(hop_text_, b.removeFromTop(line), juce::Justification::centredLeft);
+    g.drawText(memory_text_, b, juce::Justification::centredLeft);
+}
+
+void PerfOverlay::timerCallback() {
+    auto& perf = processor_.perf_;
+    auto const now = std::chrono::steady_clock::now();
+    double const us = std::chrono::duration<double, std::micro>(now - first_time_).count();
+    if (us <= 0.0) return;
+    double const cycles_per_us = static_cast<double>(qwqdsp_perf::ReadCycles() - first_cycles_) / us;
+
+    auto const callback_now = perf.callback.Read();
+    auto const hop_now = perf.hop.Read();
+    uint64_t const fft_now = perf.fft_cycles.load(std::memory_order_relaxed);
+    uint64_t const spectral_now = perf.spectral_cycles.load(std::memory_order_relaxed);
+    uint64_t const samples_now = perf.num_samples.load(std::memory_order_relaxed);
+    uint64_t const sparse_bins_now = perf.sparse_bins.load(std::memory_order_relaxed);
+    uint64_t const skipped_bins_now = perf.skipped_bins.load(std::memory_order_relaxed);
+
+    auto const callback = callback_now.Since(last_callback_);
+    auto const hop = hop_now.Since(last_hop_);
+    double const fft = static_cast<double>(fft_now - last_fft_);
+    double const spectral = static_cast<double>(spectral_now - last_spectral_);
+    double const samples = static_cast<double>(samples_now - last_samples_);
+    double const sparse_bins = static_cast<double>(sparse_bins_now - last_sparse_bins_);
+    double const skipped_bins = static_cast<double>(skipped_bins_now - last_skipped_bins_);
+    last_callback_ = callback_now;
+    last_hop_ = hop_now;
+    last_fft_ = fft_now;
+    last_spectral_ = spectral_now;
+    last_samples_ = samples_now;
+    last_sparse_bins_ = sparse_bins_now;
+    last_skipped_bins_ = skipped_bins_now;
+
+    auto to_us = [cycles_per_us](double cycles) { return juce::String{cycles / cycles_per_us, 1}; };
+    auto times = [&to_us](qwqdsp_perf::CycleHistogram::Snapshot const& s) {
+        return to_us(s.Mean()) + " p99 " + to_us(static_cast<double>(s.Quantile(0.99))) + " max " +
+               to_us(static_cast<double>(s.max)) + "us";
+    };
+
+    if (callback.count == 0) {
+        callback_text_ = "cb idle";
+    }
+    else {
+        double const fs = processor_.getSampleRate();
+        double const audio_us = fs > 0.0 ? samples / fs * 1e6 : 0.0;
+        double const load = audio_us > 0.0 ? static_cast<double>(callback.sum) / cycles_per_us / audio_us : 0.0;
+        callback_text_ = "cb " + times(callback) + "  load " + juce::String{load * 100.0, 1} + "%";
+    }
+
+    if (hop.count == 0) {
+        hop_text_ = "hop -";
+    }
+    else {
+        double const hop_sum = static_cast<double>(hop.sum);
+        double const hops_per_callback =
+            callback.count == 0 ? 0.0 : static_cast<double>(hop.count) / static_cast<double>(callback.count);
+        // with worker threads the parts can add up to more than the hop
+        hop_text_ = "hop " + times(hop) + "  " + juce::String{hops_per_callback, 1} + "/cb  fft " +
+                    juce::String{fft / hop_sum * 100.0, 0} + "% mask " + juce::String{spectral / hop_sum * 100.0, 0} +
+                    "%";
+        // bins the sparse mode left dry
+        if (sparse_bins > 0.0) {
+            hop_text_ += " skip " + juce::String{skipped_bins / sparse_bins * 100.0, 0} + "%";
+        }
+    }
+
+    auto memory = processor_.dsp_.GetFootprint();
+    memory += processor_.multires_dsp_.GetFootprint();
+    auto to_kib = [](size_t bytes) { return juce::String{static_cast<double>(bytes) / 1024.0, 0}; };
+    memory_text_ = "mem " + to_kib(memory.TotalBytes()) + " KiB  arena " + to_kib(memory.arena_bytes) + " KiB in " +
+                   juce::String{memory.num_buffers} + " buffers  +" + juce::String{memory.num_ffts} + " ffts";
+    repaint();
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <chrono>
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+#include "dsp/perf_counters.hpp"
+
+class EmptyAudioProcessor;
+
+/**
+ * @brief cpu of this instance on the audio thread, refreshed a few times a second
+ * @note callback and hop times are mean / p99 / worst over the last refresh, load is the callback time
+ *       against the audio it produced, skip the part of the bins the sparse mode left dry. memory is both
+ *       engines of the instance
+ */
+class PerfOverlay : public juce::Component, private juce::Timer {
+public:
+    static constexpr int kRefreshHz = 4;
+
+    explicit PerfOverlay(EmptyAudioProcessor& p);
+
+    void paint(juce::Graphics& g) override;
+private:
+    void timerCallback() override;
+
+    EmptyAudioProcessor& processor_;
+
+    // time stamp counter against the clock, the rate of ReadCycles() is not known otherwise
+    uint64_t first_cycles_{};
+    std::chrono::steady_clock::time_point first_time_;
+
+    qwqdsp_perf::CycleHistogram::Snapshot last_callback_;
+    qwqdsp_perf::CycleHistogram::Snapshot last_hop_;
+    uint64_t last_fft_{};
+    uint64_t last_spectral_{};
+    uint64_t last_samples_{};
+    uint64_t last_sparse_bins_{};
+    uint64_t last_skipped_bins_{};
+
+    juce::String callback_text_;
+    juce::String hop_text_;
+    juce::String memory_text_;
+};
@@ -4,7 +4,9 @@
 
 PluginUi::PluginUi(EmptyAudioProcessor& p)
     : processor_(p)
-    , preset_(*p.preset_manager_) {
+    , preset_(p.GetPresetManager())
+    , spectrum_(p)
+    , perf_(p) {
     addAndMakeVisible(preset_);
 
     for (size_t i = 0; i < phaser::SpectralPhaser::kNumLayers; ++i) {
@@ -21,6 +23,33 @@ PluginUi::PluginUi(EmptyAudioProcessor& p)
     addAndMakeVisible(freq_);
     phasy_.BindParam(*p.value_tree_, "phasy");
     addAndMakeVisible(phasy_);
+    phasy_type_.addItemList({"phase", "gain", "smooth gain"}, 1);
+    phasy_type_.setTooltip("phasy type");
+    phasy_type_attach_ = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        *p.value_tree_, "phasy_type", phasy_type_);
+    addAndMakeVisible(phasy_type_);
+
+    fft_size_.addItemList({"256", "512", "1024", "2048", "4096"}, 1);
+    fft_size_.setTooltip("fft size");
+    fft_size_attach_ = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(*p.value_tree_,
+                                                                                                "fft_size", fft_size_);
+    addAndMakeVisible(fft_size_);
+    overlap_.addItemList({"2", "4", "8"}, 1);
+    overlap_.setTooltip("overlap");
+    overlap_attach_ =
+        std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(*p.value_tree_, "overlap", overlap_);
+    addAndMakeVisible(overlap_);
+    window_.addItemList({"hann", "sqrt hann", "blackman harris", "kbd"}, 1);
+    window_.setTooltip("window");
+    window_attach_ =
+        std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(*p.value_tree_, "window", window_);
+    addAndMakeVisible(window_);
+    fft_auto_.BindParam(*p.value_tree_, "fft_auto");
+    addAndMakeVisible(fft_auto_);
+    multires_.BindParam(*p.value_tree_, "multires");
+    addAndMakeVisible(multires_);
+    addAndMakeVisible(spectrum_);
+    addAndMakeVisible(perf_);
 
     phaser_layer_.Set(0);
 }
@@ -33,6 +62,7 @@ void PluginUi::resized() {
         int w = 30;
         auto line = b.removeFromTop(w);
         phasy_.setBounds(line.removeFromRight(50).reduced(2, 0));
+        phasy_type_.setBounds(line.removeFromRight(100).reduced(2, 4));
         phaser_layer_.setBounds(line);
         auto& all_layer = phaser_layer_.GetAllCubes();
 
@@ -51,6 +81,18 @@ void PluginUi::resized() {
         morph_.setBounds(line.removeFromLeft(50));
         freq_.setBounds(line.removeFromLeft(50));
     }
+
+    {
+        auto line = b.removeFromTop(30);
+        fft_size_.setBounds(line.removeFromLeft(80).reduced(2, 4));
+        overlap_.setBounds(line.removeFromLeft(50).reduced(2, 4));
+        fft_auto_.setBounds(line.removeFromLeft(50).reduced(2, 0));
+        multires_.setBounds(line.removeFromLeft(50).reduced(2, 0));
+        window_.setBounds(line.reduced(2, 4));
+    }
+
+    perf_.setBounds(b.removeFromBottom(44).reduced(2, 2));
+    spectrum_.setBounds(b.reduced(2, 2));
 }
 
 void PluginUi::paint(juce::Graphics& g) {}
@@ -2,13 +2,15 @@
 #include "pluginshared/component.hpp"
 #include "pluginshared/preset_panel.hpp"
 #include "pluginshared/bpm_sync_ui.hpp"
+#include "perf_overlay.hpp"
+#include "spectrum_view.hpp"
 
 class EmptyAudioProcessor;
 
 class PluginUi : public juce::Component {
 public:
     static constexpr int kWidth = 320;
-    static constexpr int kHeight = 200;
+    static constexpr int kHeight = 290;
 
     explicit PluginUi(EmptyAudioProcessor& p);
 
@@ -21,6 +23,8 @@ private:
     pluginshared::PresetPanel preset_;
     ui::CubeSelector phaser_layer_;
     ui::Switch phasy_{"phasy"};
+    juce::ComboBox phasy_type_;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> phasy_type_attach_;
 
     ui::Switch enable_{"⭘"};
     ui::Dial drywet_{"drywet"};
@@ -28,4 +32,16 @@ private:
     ui::Dial phase_{"phase"};
     ui::Dial morph_{"morph"};
     ui::BpmSyncDial freq_{"freq"};
+
+    juce::ComboBox fft_size_;
+    juce::ComboBox overlap_;
+    juce::ComboBox window_;
+    ui::Switch fft_auto_{"auto"};
+    ui::Switch multires_{"multi"};
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> fft_size_attach_;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> overlap_attach_;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> window_attach_;
+
+    SpectrumView spectrum_;
+    PerfOverlay perf_;
 };
@@ -0,0 +1,109 @@
+#include "spectrum_view.hpp"
+
+#include <cmath>
+
+#include "../PluginProcessor.h"
+
+SpectrumView::SpectrumView(EmptyAudioProcessor& p)
+    : processor_(p) {
+    setInterceptsMouseClicks(false, false);
+    setOpaque(true);
+    processor_.analyzer_.AddView();
+    startTimerHz(kRefreshHz);
+}
+
+SpectrumView::~SpectrumView() {
+    processor_.analyzer_.RemoveView();
+}
+
+void SpectrumView::resized() {
+    background_ = {};
+}
+
+void SpectrumView::timerCallback() {
+    if (processor_.analyzer_.frames.Fetch()) {
+        has_frame_ = true;
+        stale_ticks_ = 0;
+        repaint();
+    }
+    else if (has_frame_ && ++stale_ticks_ > kRefreshHz / 2) {
+        has_frame_ = false;
+        repaint();
+    }
+}
+
+float SpectrumView::DbToY(float db) const noexcept {
+    float const h = static_cast<float>(getHeight());
+    return juce::jmap(juce::jlimit(kMinDb, kMaxDb, db), kMinDb, kMaxDb, h, 0.0f);
+}
+
+void SpectrumView::RenderBackground(float fs) {
+    background_fs_ = fs;
+    background_ = juce::Image{juce::Image::RGB, juce::jmax(1, getWidth()), juce::jmax(1, getHeight()), true};
+    juce::Graphics g{background_};
+    g.fillAll(juce::Colour{0xff101418});
+
+    float const w = static_cast<float>(getWidth());
+    float const h = static_cast<float>(getHeight());
+    g.setFont(9.0f);
+    for (float db = 0.0f; db > kMinDb; db -= 30.0f) {
+        float const y = DbToY(db);
+        g.setColour(juce::Colours::white.withAlpha(0.15f));
+        g.drawHorizontalLine(static_cast<int>(y), 0.0f, w);
+        g.setColour(juce::Colours::white.withAlpha(0.4f));
+        g.drawText(juce::String{static_cast<int>(db)}, 2, static_cast<int>(y), 30, 10,
+                   juce::Justification::topLeft);
+    }
+    if (fs <= 0.0f) return;
+
+    float const octaves = std::log2(fs * 0.5f / phaser::AnalyzerTap::kMinFreq);
+    for (float freq : {100.0f, 1000.0f, 10000.0f}) {
+        if (freq >= fs * 0.5f) break;
+        float const x = std::log2(freq / phaser::AnalyzerTap::kMinFreq) / octaves * w;
+        g.setColour(juce::Colours::white.withAlpha(0.15f));
+        g.drawVerticalLine(static_cast<int>(x), 0.0f, h);
+        g.setColour(juce::Colours::white.withAlpha(0.4f));
+        g.drawText(freq >= 1000.0f ? juce::String{static_cast<int>(freq / 1000.0f)} + "k"
+                                   : juce::String{static_cast<int>(freq)},
+                   static_cast<int>(x) + 2, static_cast<int>(h) - 10, 30, 10, juce::Justification::bottomLeft);
+    }
+}
+
+void SpectrumView::paint(juce::Graphics& g) {
+    auto const& frame = processor_.analyzer_.frames.Front();
+    float const fs = frame.fs > 0.0f ? frame.fs : static_cast<float>(processor_.getSampleRate());
+    if (!background_.isValid() || background_fs_ != fs) {
+        RenderBackground(fs);
+    }
+    g.drawImageAt(background_, 0, 0);
+    if (!has_frame_) return;
+
+    constexpr size_t kNumPoints = phaser::AnalyzerTap::kNumPoints;
+    float const dx = static_cast<float>(getWidth()) / static_cast<float>(kNumPoints - 1);
+    juce::Path spectrum;
+    juce::Path mask;
+    for (size_t i = 0; i < kNumPoints; ++i) {
+        float const x = static_cast<float>(i) * dx;
+        float const spectrum_y = DbToY(juce::Decibels::gainToDecibels(frame.magnitude[i], kMinDb));
+        float const mask_y = DbToY(juce::Decibels::gainToDecibels(frame.mask[i], kMinDb));
+        if (i == 0) {
+            spectrum.startNewSubPath(x, spectrum_y);
+            mask.startNewSubPath(x, mask_y);
+        }
+        else {
+            spectrum.lineTo(x, spectrum_y);
+            mask.lineTo(x, mask_y);
+        }
+    }
+
+    juce::Path fill{spectrum};
+    fill.lineTo(static_cast<float>(getWidth()), static_cast<float>(getHeight()));
+    fill.lineTo(0.0f, static_cast<float>(getHeight()));
+    fill.closeSubPath();
+    g.setColour(juce::Colours::skyblue.withAlpha(0.3f));
+    g.fillPath(fill);
+    g.setColour(juce::Colours::skyblue);
+    g.strokePath(spectrum, juce::PathStrokeType{1.0f});
+    g.setColour(juce::Colours::orange);
+    g.strokePath(mask, juce::PathStrokeType{1.5f});
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <juce_gui_basics/juce_gui_basics.h>
+
+class EmptyAudioProcessor;
+
+/**
+ * @brief input spectrum of the first channels and the mask, log frequency
+ * @note only repaints when a new frame came in, at most kRefreshHz times a second. the grid is drawn
+ *       into an image once per size and sample rate
+ */
+class SpectrumView : public juce::Component, private juce::Timer {
+public:
+    static constexpr int kRefreshHz = 30;
+    static constexpr float kMinDb = -90.0f;
+    static constexpr float kMaxDb = 6.0f;
+
+    explicit SpectrumView(EmptyAudioProcessor& p);
+    ~SpectrumView() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+private:
+    void timerCallback() override;
+    void RenderBackground(float fs);
+    float DbToY(float db) const noexcept;
+
+    EmptyAudioProcessor& processor_;
+    juce::Image background_;
+    float background_fs_{};
+    bool has_frame_{};
+    // refreshes without a new frame, the phaser does not publish while idle or silent
+    int stale_ticks_{};
+};